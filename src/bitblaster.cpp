@@ -47,9 +47,27 @@ BitBlaster :: BitBlaster(vector<int> &mins, vector<int> &maxs) {
     int n = vars.query_size();
     vars.add_vars(len);
     bitstart.push_back(n);
+    // small unknowns get an order encoding; the binary bits are only
+    // given a meaning when they are needed
+    if (maxima[i] <= UNARY_LIMIT) {
+      orderstart.push_back(vars.query_size());
+      binary_linked.push_back(false);
+      vars.add_vars(maxima[i]);
+      // o_{k+1} -> o_k
+      for (int k = 1; k < maxima[i]; k++)
+        addreq(new Or(new AntiVar(order_bit(i, k+1)),
+                      new Var(order_bit(i, k))));
+      if (minima[i] > maxima[i]) addreq(new Bottom);
+      else for (int k = 1; k <= minima[i]; k++)
+        addreq(new Var(order_bit(i, k)));
+    }
     // add requirements for minima and maxima
-    inequality_left(i, minima[i]);
-    if (len <= MAXBITS) inequality_right(maxima[i], i);
+    else {
+      orderstart.push_back(-1);
+      binary_linked.push_back(true);
+      inequality_left(i, minima[i]);
+      if (len <= MAXBITS) inequality_right(maxima[i], i);
+    }
   }
   interestingnums = mins.size();
 }
@@ -80,19 +98,32 @@ bool BitBlaster :: solve(PFormula formula, vector<int> &values) {
 
 void BitBlaster :: inequality(PPol l, PPol r, int conditional) {
   if (l->query_unknown() && r->query_integer()) {
-    inequality_left(dynamic_cast<Unknown*>(l)->query_index(),
-                    dynamic_cast<Integer*>(r)->query_value(),
-                    conditional);
+    int index = dynamic_cast<Unknown*>(l)->query_index();
+    int num = dynamic_cast<Integer*>(r)->query_value();
+    if (query_unary(index))
+      addreqif(new Var(order_bit(index, num)), conditional);
+    else inequality_left(index, num, conditional);
   }
   else if (l->query_integer() && r->query_unknown()) {
-    inequality_right(dynamic_cast<Integer*>(l)->query_value(),
-                     dynamic_cast<Unknown*>(r)->query_index(),
-                     conditional);
+    int num = dynamic_cast<Integer*>(l)->query_value();
+    int index = dynamic_cast<Unknown*>(r)->query_index();
+    if (query_unary(index))
+      addreqif(new AntiVar(order_bit(index, num+1)), conditional);
+    else inequality_right(num, index, conditional);
   }
   else if (l->query_unknown() && r->query_unknown()) {
-    inequality_both(dynamic_cast<Unknown*>(l)->query_index(),
-                    dynamic_cast<Unknown*>(r)->query_index(),
-                    conditional);
+    int index1 = dynamic_cast<Unknown*>(l)->query_index();
+    int index2 = dynamic_cast<Unknown*>(r)->query_index();
+    if (query_unary(index1) && query_unary(index2)) {
+      vector<int> a = order_representation(index1);
+      vector<int> b = order_representation(index2);
+      unary_inequality(a, b, conditional);
+    }
+    else {
+      link_binary(index1);
+      link_binary(index2);
+      inequality_both(index1, index2, conditional);
+    }
   }
   else {
     cout << "Error: unexpected inequality: " << l->to_string()
@@ -171,6 +202,59 @@ int BitBlaster :: new_var() {
   return ret;
 }
 
+int BitBlaster :: new_binary_unknown(int len) {
+  int num = minima.size();
+  minima.push_back(0);
+  maxima.push_back(1 << len);
+  bitstart.push_back(vars.query_size());
+  numbits.push_back(len);
+  orderstart.push_back(-1);
+  binary_linked.push_back(true);
+  vars.add_vars(len);
+  return num;
+}
+
+bool BitBlaster :: query_unary(int index) {
+  return orderstart[index] != -1;
+}
+
+int BitBlaster :: order_bit(int index, int k) {
+  if (k <= 0) return TRUEBIT;
+  if (k > maxima[index]) return FALSEBIT;
+  return orderstart[index] + k - 1;
+}
+
+int BitBlaster :: order_literal(vector<int> &rep, int k) {
+  if (k <= 0) return TRUEBIT;
+  if (k > rep.size()) return FALSEBIT;
+  return rep[k-1];
+}
+
+vector<int> BitBlaster :: order_representation(int unknown) {
+  vector<int> ret;
+  for (int k = 1; k <= maxima[unknown]; k++)
+    ret.push_back(order_bit(unknown, k));
+  return ret;
+}
+
+int BitBlaster :: negation(int x) {
+  int ret = new_var();
+  is_different(ret, x);
+  return ret;
+}
+
+void BitBlaster :: link_binary(int index) {
+  if (binary_linked[index]) return;
+  binary_linked[index] = true;
+  // o_k -> bits >= k, and -o_k -> k-1 >= bits
+  for (int k = 1; k <= maxima[index]; k++) {
+    int o = order_bit(index, k);
+    inequality_left(index, k, o);
+    inequality_right(k-1, index, negation(o));
+  }
+  inequality_right(maxima[index], index);
+}
+
 int BitBlaster :: overflow_bit(int index) {
   if (numbits[index] <= MAXBITS)
     cout << "overflow bit queried of number without overflow" << endl;
@@ -259,6 +343,12 @@ void BitBlaster :: is_triple_xor(int x, int y, int z, int u, int cond) {
 
 int BitBlaster :: recover_number(int index) {
   int ret = 0;
+  if (query_unary(index)) {
+    for (int k = 1; k <= maxima[index]; k++) {
+      if (vars.query_value(order_bit(index, k)) == TRUE) ret = k;
+    }
+    return ret;
+  }
   for (int i = 0; i < numbits[index]; i++) {
     int id = bit(index, i);
     if (vars.query_value(id) == TRUE) ret += 1 << i;
@@ -425,6 +515,7 @@ void BitBlaster :: inequality_both(int u1, int u2, int conditional) {
 
 vector<int> BitBlaster :: representation(int unknown) {
   vector<int> ret;
+  link_binary(unknown);
   for (int i = 0; i < numbits[unknown]; i++)
     ret.push_back(bit(unknown, i));
   return ret;
@@ -448,6 +539,12 @@ vector<int> BitBlaster :: number_representation(int num) {
 void BitBlaster :: set_squares(map<int,int> &squares) {
   for (map<int,int>::iterator it = squares.begin(); it != squares.end(); it++) {
     //cout << "defining: a" << it->first << " = a" << it->second << " * a" << it->second << endl;
+    if (query_unary(it->first) && query_unary(it->second)) {
+      vector<int> a = order_representation(it->second);
+      set_unary_product(it->first, a, a);
+      continue;
+    }
+    link_binary(it->first);
     vector<int> a = representation(it->second);
     vector<int> b = representation(it->second);
     set_product(it->first, a, b);
@@ -457,6 +554,14 @@ void BitBlaster :: set_squares(map<int,int> &squares) {
 void BitBlaster :: set_unknown_products(PairMap &prods) {
   for (PairMap::iterator it = prods.begin(); it != prods.end(); it++) {
     //cout << "defining: a" << it->first << " = a" << it->second.first << " * a" << it->second.second << endl;
+    if (query_unary(it->first) && query_unary(it->second.first) &&
+        query_unary(it->second.second)) {
+      vector<int> a = order_representation(it->second.first);
+      vector<int> b = order_representation(it->second.second);
+      set_unary_product(it->first, a, b);
+      continue;
+    }
+    link_binary(it->first);
     vector<int> a = representation(it->second.first);
     vector<int> b = representation(it->second.second);
     if (a.size() >= b.size()) set_product(it->first, a, b);
@@ -467,6 +572,12 @@ void BitBlaster :: set_unknown_products(PairMap &prods) {
 void BitBlaster :: set_known_products(PairMap &prods) {
   for (PairMap::iterator it = prods.begin(); it != prods.end(); it++) {
     //cout << "defining: a" << it->first << " = " << it->second.first << " * a" << it->second.second << endl;
+    if (query_unary(it->first) && query_unary(it->second.second)) {
+      vector<int> a = order_representation(it->second.second);
+      set_unary_scale(it->first, a, it->second.first);
+      continue;
+    }
+    link_binary(it->first);
     vector<int> a = representation(it->second.second);
     vector<int> b = number_representation(it->second.first);
     set_product(it->first, a, b);
@@ -476,6 +587,14 @@ void BitBlaster :: set_known_products(PairMap &prods) {
 void BitBlaster :: set_unknown_sums(PairMap &sums) {
   for (PairMap::iterator it = sums.begin(); it != sums.end(); it++) {
     //cout << "defining: a" << it->first << " = a" << it->second.first << " + a" << it->second.second << endl;
+    if (query_unary(it->first) && query_unary(it->second.first) &&
+        query_unary(it->second.second)) {
+      vector<int> a = order_representation(it->second.first);
+      vector<int> b = order_representation(it->second.second);
+      set_unary_sum(it->first, a, b);
+      continue;
+    }
+    link_binary(it->first);
     vector<int> a = representation(it->second.first);
     vector<int> b = representation(it->second.second);
     set_sum(it->first, a, b);
@@ -485,12 +604,85 @@ void BitBlaster :: set_unknown_sums(PairMap &sums) {
 void BitBlaster :: set_known_sums(PairMap &sums) {
   for (PairMap::iterator it = sums.begin(); it != sums.end(); it++) {
     //cout << "defining: a" << it->first << " = " << it->second.first << " + a" << it->second.second << endl;
+    if (query_unary(it->first) && query_unary(it->second.second)) {
+      vector<int> a = order_representation(it->second.second);
+      set_unary_shift(it->first, a, it->second.first);
+      continue;
+    }
+    link_binary(it->first);
     vector<int> a = representation(it->second.second);
     vector<int> b = number_representation(it->second.first);
     set_sum(it->first, a, b);
   }
 }
 
+/* ========== order-encoded arithmetic ========== */
+
+void BitBlaster :: unary_inequality(vector<int> &a, vector<int> &b,
+                                    int cond) {
+  // b >= k -> a >= k
+  for (int k = 1; k <= b.size(); k++) {
+    addreqif(new Or(new AntiVar(b[k-1]), new Var(order_literal(a, k))),
+             cond);
+  }
+}
+
+void BitBlaster :: set_unary_sum(int result, vector<int> &a,
+                                 vector<int> &b) {
+  for (int i = 0; i <= a.size(); i++) {
+    for (int j = 0; j <= b.size(); j++) {
+      // a >= i /\ b >= j -> result >= i + j
+      addreq(new Or(new AntiVar(order_literal(a, i)),
+                    new AntiVar(order_literal(b, j)),
+                    new Var(order_bit(result, i + j))));
+      // a < i+1 /\ b < j+1 -> result < i+j+1
+      addreq(new Or(new Var(order_literal(a, i+1)),
+                    new Var(order_literal(b, j+1)),
+                    new AntiVar(order_bit(result, i + j + 1))));
+    }
+  }
+}
+
+void BitBlaster :: set_unary_product(int result, vector<int> &a,
+                                     vector<int> &b) {
+  for (int i = 0; i <= a.size(); i++) {
+    for (int j = 0; j <= b.size(); j++) {
+      // a >= i /\ b >= j -> result >= i * j
+      if (i > 0 && j > 0) {
+        addreq(new Or(new AntiVar(order_literal(a, i)),
+                      new AntiVar(order_literal(b, j)),
+                      new Var(order_bit(result, i * j))));
+      }
+      // a < i+1 /\ b < j+1 -> result < i*j+1
+      addreq(new Or(new Var(order_literal(a, i+1)),
+                    new Var(order_literal(b, j+1)),
+                    new AntiVar(order_bit(result, i * j + 1))));
+    }
+  }
+}
+
+void BitBlaster :: set_unary_shift(int result, vector<int> &a, int num) {
+  for (int i = 0; i <= a.size(); i++) {
+    addreq(new Or(new AntiVar(order_literal(a, i)),
+                  new Var(order_bit(result, num + i))));
+    addreq(new Or(new Var(order_literal(a, i+1)),
+                  new AntiVar(order_bit(result, num + i + 1))));
+  }
+}
+
+void BitBlaster :: set_unary_scale(int result, vector<int> &a, int num) {
+  for (int i = 0; i <= a.size(); i++) {
+    if (i > 0 && num > 0) {
+      addreq(new Or(new AntiVar(order_literal(a, i)),
+                    new Var(order_bit(result, num * i))));
+    }
+    addreq(new Or(new Var(order_literal(a, i+1)),
+                  new AntiVar(order_bit(result, num * i + 1))));
+  }
+}
+
+/* ========== binary arithmetic ========== */
+
 void BitBlaster :: set_sum(int result, vector<int> &a, vector<int> &b) {
   int alen = a.size(), blen = b.size(), rlen = numbits[result];
   int i;
@@ -702,12 +894,7 @@ void BitBlaster :: set_product(int result, vector<int> &a, vector<int> &b) {
       break;
     }
     else {
-      int num = minima.size();
-      minima.push_back(0);
-      maxima.push_back((1 << (MAXBITS + 1)));
-      bitstart.push_back(vars.query_size());
-      numbits.push_back(MAXBITS + 1);
-      vars.add_vars(MAXBITS+1);
+      int num = new_binary_unknown(MAXBITS + 1);
       set_sum(num, parts[parts.size()-1], parts[parts.size()-2]);
       parts.pop_back();
       parts.pop_back();
@@ -21,6 +21,9 @@
 #include "formula.h"
 
 #define MAXBITS 8
+#define UNARY_LIMIT 3
+  // unknowns whose maximum is at most UNARY_LIMIT are given an order
+  // encoding rather than a binary one; set to 0 to always use binary
 
 typedef pair<int,int> IntPair;
 typedef map<int,IntPair> PairMap;
@@ -31,11 +34,24 @@ typedef map<int,IntPair> PairMap;
  * and finds a satisfying assignment, if one exists, by encoding the
  * constraints into a satisfiability problem of proposition logic and
  * sending this to a sat-solver.
+ *
+ * Unknowns with a large range are encoded in binary, with an overflow
+ * bit if necessary.  Unknowns with a small range (at most UNARY_LIMIT)
+ * are instead given an order encoding: variables o_1,...,o_max where
+ * o_k holds if and only if the unknown is at least k.  Sums, products
+ * and comparisons between order-encoded unknowns are done directly on
+ * this representation; if an order-encoded unknown is combined with a
+ * binary one, its binary bits are linked to the order variables first.
  */
 
 class BitBlaster {
   private:
     vector<int> minima, maxima, bitstart, numbits;
+    vector<int> orderstart;
+      // for order-encoded unknowns, the index of o_1; -1 for binary
+    vector<bool> binary_linked;
+      // for order-encoded unknowns, whether the binary bits have been
+      // linked to the order variables yet
     int interestingnums;
     And *sat_formula;
     int TRUEBIT, FALSEBIT;
@@ -51,6 +67,26 @@ class BitBlaster {
       // returns the overflow bit of unknown index (if it has one)
     int new_var();
       // creates a new propositional variable and returns it
+    int new_binary_unknown(int len);
+      // creates a new binary unknown with len bits and returns its
+      // index
+
+    bool query_unary(int index);
+      // returns whether the given unknown is order-encoded
+    int order_bit(int index, int k);
+      // for an order-encoded unknown, returns the variable which holds
+      // if and only if the unknown is at least k (TRUEBIT if k <= 0,
+      // FALSEBIT if k exceeds the maximum)
+    int order_literal(vector<int> &rep, int k);
+      // returns rep[k-1], or TRUEBIT if k <= 0 and FALSEBIT if k is
+      // too large for rep
+    vector<int> order_representation(int unknown);
+      // returns [o_1,...,o_max] for an order-encoded unknown
+    void link_binary(int index);
+      // makes sure that the bits of an order-encoded unknown equal
+      // the number it represents
+    int negation(int x);
+      // returns a new variable which holds if and only if x does not
 
     void is_equal(int x, int y, int anticond = -1);
       // adds the requirement that bit x = bit y
@@ -100,10 +136,22 @@ class BitBlaster {
       // if cond is given, this becomes c -> u1 >= u2
     void inequality(PPol a, PPol b, int cond = -1);
       // adds the requirement cond -> a >= b
+    void unary_inequality(vector<int> &a, vector<int> &b, int cond = -1);
+      // adds the requirement cond -> a >= b for order representations
     void set_sum(int result, vector<int> &a, vector<int> &b);
       // adds the requirement: result = a + b
     void set_product(int result, vector<int> &a, vector<int> &b);
       // adds the requirement: result = a * b
+    void set_unary_sum(int result, vector<int> &a, vector<int> &b);
+      // adds the requirement result = a + b, where result is
+      // order-encoded and a, b are order representations
+    void set_unary_product(int result, vector<int> &a, vector<int> &b);
+      // adds the requirement result = a * b, where result is
+      // order-encoded and a, b are order representations
+    void set_unary_shift(int result, vector<int> &a, int num);
+      // adds the requirement result = num + a (order-encoded)
+    void set_unary_scale(int result, vector<int> &a, int num);
+      // adds the requirement result = num * a (order-encoded)
 
   public:
     BitBlaster(vector<int> &minima, vector<int> &maxima);
@@ -17,28 +17,68 @@
 #include "dependencygraph.h"
 #include "outputmodule.h"
 #include "substitution.h"
+#include <algorithm>
 #include <cstdio>
+#include <pthread.h>
+#include <unistd.h>
 
 DependencyGraph :: DependencyGraph(Alphabet &Sigma, DPSet &P,
-                                   vector<MatchRule*> &R)
+                                   vector<MatchRule*> &R,
+                                   EdgeCache *cache)
     :rules(R), pairs(P) {
   
   int i, j;
 
-  get_eating_info(Sigma);
-  get_reduction_info(Sigma);
+  if (cache != NULL && cache->filled) {
+    noneatingpos = cache->noneatingpos;
+    symbol_index = cache->symbol_index;
+    can_reduce_to = cache->can_reduce_to;
+  }
+  else {
+    get_eating_info(Sigma);
+    get_reduction_info(Sigma);
+    if (cache != NULL) {
+      cache->noneatingpos = noneatingpos;
+      cache->symbol_index = symbol_index;
+      cache->can_reduce_to = can_reduce_to;
+      cache->filled = true;
+    }
+  }
+
+  // find the connections which were not calculated for an earlier
+  // graph, and calculate them (possibly in parallel)
+  vector< pair<int,int> > todo;
+  vector<char> found;
+  for (i = 0; i < P.size(); i++) {
+    for (j = 0; j < P.size(); j++) {
+      pair<int,int> key(P[i]->query_identity(), P[j]->query_identity());
+      if (cache == NULL || cache->edges.find(key) == cache->edges.end())
+        todo.push_back(make_pair(i, j));
+    }
+  }
+  estimate_edges(todo, found);
 
-  // initialise the graph, and calculate all connections
+  // initialise the graph from the new connections and the cache
+  int k = 0;
   for (i = 0; i < P.size(); i++) {
     graph_entry dummy;
+    intlist succ;
     for (j = 0; j < P.size(); j++) {
-      dummy.push_back(connection_possible(P[i], P[j]));
+      pair<int,int> key(P[i]->query_identity(), P[j]->query_identity());
+      if (k < todo.size() && todo[k].first == i && todo[k].second == j) {
+        dummy.push_back(found[k] != 0);
+        if (cache != NULL) cache->edges[key] = dummy[j];
+        k++;
+      }
+      else dummy.push_back(cache->edges[key]);
+      if (dummy[j]) succ.push_back(j);
     }
     graph.push_back(dummy);
+    successors.push_back(succ);
   }
 
-  // and determine the reachability array
-  calculate_reachable();
+  // and determine the strongly connected components
+  calculate_sccs();
 }
 
 /* ================= generally helpful functions ================= */
@@ -59,6 +99,58 @@ bool DependencyGraph :: is_constructor(PTerm symbol) {
 
 /* ==================== estimating the graph ===================== */
 
+struct EdgeJob {
+  DependencyGraph *graph;
+  vector< pair<int,int> > *todo;
+  vector<char> *result;
+  int start, step;
+};
+
+void DependencyGraph :: estimate_edges(vector< pair<int,int> > &todo,
+                                       vector<char> &result) {
+  result.resize(todo.size(), 0);
+
+  int threads = 1;
+  if (todo.size() >= GRAPH_PARALLEL_MINIMUM) {
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > GRAPH_MAX_THREADS) threads = GRAPH_MAX_THREADS;
+    if (threads < 1) threads = 1;
+  }
+
+  // thread t handles the edges t, t + threads, t + 2 * threads, ...;
+  // the current thread takes the first share itself
+  vector<EdgeJob> jobs(threads);
+  vector<pthread_t> ids(threads);
+  vector<bool> started(threads, false);
+  for (int t = 0; t < threads; t++) {
+    jobs[t].graph = this;
+    jobs[t].todo = &todo;
+    jobs[t].result = &result;
+    jobs[t].start = t;
+    jobs[t].step = threads;
+  }
+  for (int t = 1; t < threads; t++) {
+    started[t] = pthread_create(&ids[t], NULL, edge_worker, &jobs[t]) == 0;
+    if (!started[t]) edge_worker(&jobs[t]);
+  }
+  edge_worker(&jobs[0]);
+  for (int t = 1; t < threads; t++) {
+    if (started[t]) pthread_join(ids[t], NULL);
+  }
+}
+
+void *DependencyGraph :: edge_worker(void *job) {
+  EdgeJob *info = (EdgeJob*)job;
+  DependencyGraph *graph = info->graph;
+  vector<DependencyPair*> &P = graph->pairs;
+  vector< pair<int,int> > &todo = *info->todo;
+  for (int k = info->start; k < todo.size(); k += info->step) {
+    (*info->result)[k] =
+      graph->connection_possible(P[todo[k].first], P[todo[k].second]);
+  }
+  return NULL;
+}
+
 bool DependencyGraph :: connection_possible(DependencyPair *pair1,
                                             DependencyPair *pair2) {
 
@@ -100,16 +192,25 @@ bool DependencyGraph :: connection_possible(DependencyPair *pair1,
   delete combination;
 
   // finally, check whether the arguments can actually reduce!
+  map<int,int> bound;
   for (int i = 1; i < n; i++) {
-    if (!reduction_possible(splitfrom[i], splitto[i], pair2))
+    if (!reduction_possible(splitfrom[i], splitto[i], pair2, bound))
       return false;
   }
 
   return true;
 }
 
+/* returns the variable of from which corresponds to x in to */
+static int bound_index(map<int,int> &bound, int x) {
+  map<int,int>::iterator it = bound.find(x);
+  if (it == bound.end()) return x;
+  return it->second;
+}
+
 bool DependencyGraph :: reduction_possible(PTerm from, PTerm to,
-                                           DependencyPair *todp) {
+                                           DependencyPair *todp,
+                                           map<int,int> &bound) {
   
   // for a reduction to be possible, types must correspond
   PType type1 = from->query_type();
@@ -123,7 +224,9 @@ bool DependencyGraph :: reduction_possible(PTerm from, PTerm to,
   // is specified as non-eating), also occur in from
   Varset into = get_certain_variables(to, todp);
   Varset infrom = from->free_var();
-  if (!infrom.contains(into)) return false;
+  for (Varset::iterator it = into.begin(); it != into.end(); it++) {
+    if (!infrom.contains(bound_index(bound, *it))) return false;
+  }
 
   // s --> Z[x1,...,xn] if for all variables other than x1,...,xn,
   // s can reduce them away
@@ -133,7 +236,8 @@ bool DependencyGraph :: reduction_possible(PTerm from, PTerm to,
     for (int i = 0; i < to->number_children(); i++) {
       PTerm sub = to->get_child(i);
       if (!sub->query_variable()) return true;  // ergh
-      problems.remove(dynamic_cast<PVariable>(sub));
+      int x = dynamic_cast<PVariable>(sub)->query_index();
+      problems.remove(bound_index(bound, x));
     }
     // check whether they can be
     for (Varset::iterator it = problems.begin();
@@ -149,15 +253,15 @@ bool DependencyGraph :: reduction_possible(PTerm from, PTerm to,
     if (!to->query_abstraction()) return false;
     Abstraction *fabs = dynamic_cast<Abstraction*>(from);
     Abstraction *tabs = dynamic_cast<Abstraction*>(to);
-    PVariable fabsx = fabs->query_abstraction_variable();
-    PVariable tabsx = tabs->query_abstraction_variable();
-    PVariable newvar = new Variable(tabsx->query_type()->copy(),
-                                    fabsx->query_index());
-    Substitution sub;
-    sub[tabs->query_abstraction_variable()] = newvar;
-    PTerm test = tabs->subterm("1")->copy()->apply_substitution(sub);
-    bool ret = reduction_possible(from->subterm("1"), test, todp);
-    delete test;
+    int fx = fabs->query_abstraction_variable()->query_index();
+    int tx = tabs->query_abstraction_variable()->query_index();
+    bool shadows = bound.find(tx) != bound.end();
+    int old = shadows ? bound[tx] : 0;
+    bound[tx] = fx;
+    bool ret = reduction_possible(from->subterm("1"),
+                                  to->subterm("1"), todp, bound);
+    if (shadows) bound[tx] = old;
+    else bound.erase(tx);
     return ret;
   }
 
@@ -165,7 +269,7 @@ bool DependencyGraph :: reduction_possible(PTerm from, PTerm to,
   if (from->query_variable()) {
     if (!to->query_variable()) return false;
     return dynamic_cast<PVariable>(from)->query_index() !=
-           dynamic_cast<PVariable>(to)->query_index();
+           bound_index(bound, dynamic_cast<PVariable>(to)->query_index());
   }
   // if left is a single constructor, then right should be the same
   if (is_constructor(from)) {
@@ -190,9 +294,9 @@ bool DependencyGraph :: reduction_possible(PTerm from, PTerm to,
   if (fhead->query_variable() || is_constructor(fhead)) {
     if (!to->query_application()) return false;
     return reduction_possible(from->subterm("1"), to->subterm("1"),
-                              todp) &&
+                              todp, bound) &&
            reduction_possible(from->subterm("2"), to->subterm("2"),
-                              todp);
+                              todp, bound);
   }
 
   if (!fhead->query_constant()) return true;   // shouldn't happen!
@@ -201,11 +305,11 @@ bool DependencyGraph :: reduction_possible(PTerm from, PTerm to,
   // if from is headed by a defined symbol, see whether it could
   // reduce to something of the form of to
   if (to->query_abstraction())
-    return can_reduce_to[f->query_name() + " : #ABS"];
+    return reduces_to(f->query_name(), "#ABS");
   if (thead->query_variable())
-    return can_reduce_to[f->query_name() + " : #VAR"];
+    return reduces_to(f->query_name(), "#VAR");
   if (thead->query_constant())
-    return can_reduce_to[f->query_name() + " : " + thead->to_string(false)];
+    return reduces_to(f->query_name(), thead->to_string(false));
 
   // this probably shouldn't happen
   return true;
@@ -353,165 +457,232 @@ bool DependencyGraph :: at_non_eating_pos(PTerm s, int Z) {
   
   if (!head->query_constant()) return false;    // shouldn't happen!
   string headname = head->to_string(false);
+  // use find rather than [], as this may run in several threads
+  map<string,graph_entry>::iterator it = noneatingpos.find(headname);
+  int known = it == noneatingpos.end() ? 0 : it->second.size();
   
   for (int i = 0; i < splits.size()-1; i++) {
-    if (i >= noneatingpos[headname].size()) {
+    if (i >= known) {
       if (!is_constructor(head)) break;
     }
-    else if (!noneatingpos[headname][i]) continue;
+    else if (!it->second[i]) continue;
     if (at_non_eating_pos(splits[i+1], Z)) return true;
   }
   
   return false;
 }
 
+#define WORD_BITS (8 * sizeof(unsigned long))
+
+static void set_bit(bitrow &row, int j) {
+  row[j / WORD_BITS] |= 1UL << (j % WORD_BITS);
+}
+
+static bool test_bit(const bitrow &row, int j) {
+  return (row[j / WORD_BITS] >> (j % WORD_BITS)) & 1;
+}
+
+/**
+ * fill can_reduce_to, a matrix with a row for every symbol and a
+ * column for every symbol as well as #ABS and #VAR; the immediate
+ * reductions are read off the rules, and the transitive closure is
+ * then computed with Warshall's algorithm, handling a whole word of
+ * columns at once
+ */
 void DependencyGraph :: get_reduction_info(Alphabet &Sigma) {
-  int i;
-  
-  // step 1: initialise can_reduce_to
+  int i, j, k;
+
+  // step 1: number the symbols, and initialise can_reduce_to to the
+  // identity relation
   vector<string> names = Sigma.get_all();
-  for (i = 0; i < names.size(); i++) {
-    for (int j = 0; j < names.size(); j++) {
-      can_reduce_to[names[i] + " : " + names[j]] = (i == j);
-    }
-    can_reduce_to[names[i] + " : #ABS"] = false;
-    can_reduce_to[names[i] + " : #VAR"] = false;
-  }
+  int n = names.size();
+  int abscol = n;
+  int words = (n + 2 + WORD_BITS - 1) / WORD_BITS;
+  for (i = 0; i < n; i++) symbol_index[names[i]] = i;
+  can_reduce_to.resize(n, bitrow(words, 0));
+  for (i = 0; i < n; i++) set_bit(can_reduce_to[i], i);
 
   // step 2: note all immediate reductions
   for (i = 0; i < rules.size(); i++) {
     string lhead = rules[i]->query_left_side()->query_head()->to_string(false);
+    map<string,int>::iterator it = symbol_index.find(lhead);
+    if (it == symbol_index.end()) continue;
+    bitrow &row = can_reduce_to[it->second];
     PTerm right = rules[i]->query_right_side();
     if (right->query_abstraction()) {
-      can_reduce_to[lhead + " : #ABS"] = true;
+      set_bit(row, abscol);
       while (right->query_abstraction()) right = right->subterm("1");
     }
     PTerm rhead = right->query_head();
     if (rhead->query_constant()) {
-      can_reduce_to[lhead + " : " + rhead->to_string(false)] = true;
+      it = symbol_index.find(rhead->to_string(false));
+      if (it != symbol_index.end()) set_bit(row, it->second);
     }
     if (rhead->query_meta() || rhead->query_variable()) {
       // meta-variables might be instantiated with ANYTHING
-      for (int j = 0; j < names.size(); j++) {
-        can_reduce_to[lhead + " : " + names[j]] = true;
-      }
-      can_reduce_to[lhead + " : #ABS"] = true;
-      can_reduce_to[lhead + " : #VAR"] = true;
+      for (j = 0; j < n + 2; j++) set_bit(row, j);
     }
   }
-  
-  // step 3: determine the closure
-  bool changed = true;
-  while (changed) {
-    changed = false;
-    for (i = 0; i < names.size(); i++) {
-      for (int j = 0; j < names.size(); j++) {
-        if (i == j || !can_reduce_to[names[i] + " : " + names[j]]) continue;
-        for (int k = -2; k < (int)(names.size()); k++) {
-          string name;
-          if (k == -2) name = "#VAR";
-          else if (k == -1) name = "#ABS";
-          else name = names[k];
-          if (can_reduce_to[names[j] + " : " + name] &&
-              !can_reduce_to[names[i] + " : " + name]) {
-            changed = true;
-            can_reduce_to[names[i] + " : " + name] = true;
-          }
-        }
-      }
+
+  // step 3: determine the closure; #ABS and #VAR have no outgoing
+  // reductions, so only the symbols need to be used as intermediate
+  for (k = 0; k < n; k++) {
+    bitrow &via = can_reduce_to[k];
+    for (i = 0; i < n; i++) {
+      if (i == k || !test_bit(can_reduce_to[i], k)) continue;
+      bitrow &row = can_reduce_to[i];
+      for (j = 0; j < words; j++) row[j] |= via[j];
     }
   }
 }
 
+bool DependencyGraph :: reduces_to(string f, string g) {
+  map<string,int>::iterator it = symbol_index.find(f);
+  if (it == symbol_index.end()) return false;
+  int n = symbol_index.size();
+  int column;
+  if (g == "#ABS") column = n;
+  else if (g == "#VAR") column = n + 1;
+  else {
+    map<string,int>::iterator jt = symbol_index.find(g);
+    if (jt == symbol_index.end()) return false;
+    column = jt->second;
+  }
+  return test_bit(can_reduce_to[it->second], column);
+}
+
 /* ===================== calculating cycles ====================== */
 
-void DependencyGraph :: calculate_reachable() {
-  int N = graph.size();
-  reachable.resize(N);
-  for (int i = 0; i < N; i++) {
-    // do a floodfill, starting in point i
-    vector<int> stack;
-    reachable[i].resize(N);
-    for (int j = 0; j < N; j++) {
-      reachable[i][j] = graph[i][j];
-      if (graph[i][j]) stack.push_back(j);
-    }
-    while (stack.size() > 0) {
-      int lastpoint = stack[stack.size()-1];
-      stack.pop_back();
-      for (int k = 0; k < N; k++) {
-        if (graph[lastpoint][k] && !reachable[i][k]) {
-          reachable[i][k] = true;
-          stack.push_back(k);
-        }   
-      }   
+/* sorts components by their smallest element */
+static bool component_less(const intlist &a, const intlist &b) {
+  return a[0] < b[0];
+}
+
+void DependencyGraph :: calculate_sccs() {
+  intlist nodes;
+  for (int i = 0; i < pairs.size(); i++) {
+    if (pairs[i] != NULL) nodes.push_back(i);
+  }
+  components.clear();
+  find_components(nodes, components);
+  sort(components.begin(), components.end(), component_less);
+}
+
+void DependencyGraph :: find_components(intlist &nodes,
+                                        vector<intlist> &result) {
+  int N = pairs.size();
+  vector<bool> inside(N, false), onstack(N, false);
+  vector<int> index(N, -1), lowlink(N, 0);
+  intlist stack;
+  int counter = 0;
+  int i;
+
+  for (i = 0; i < nodes.size(); i++) inside[nodes[i]] = true;
+
+  for (i = 0; i < nodes.size(); i++) {
+    if (index[nodes[i]] != -1) continue;
+
+    // a depth-first search with an explicit call stack, to avoid deep
+    // recursion on large graphs; each entry holds a node and the
+    // position of the next successor to consider
+    vector< pair<int,int> > calls;
+    calls.push_back(make_pair(nodes[i], 0));
+    index[nodes[i]] = lowlink[nodes[i]] = counter++;
+    stack.push_back(nodes[i]);
+    onstack[nodes[i]] = true;
+
+    while (!calls.empty()) {
+      int v = calls.back().first;
+      int pos = calls.back().second;
+      if (pos < successors[v].size()) {
+        calls.back().second++;
+        int w = successors[v][pos];
+        if (!inside[w]) continue;
+        if (index[w] == -1) {
+          index[w] = lowlink[w] = counter++;
+          stack.push_back(w);
+          onstack[w] = true;
+          calls.push_back(make_pair(w, 0));
+        }
+        else if (onstack[w] && index[w] < lowlink[v])
+          lowlink[v] = index[w];
+        continue;
+      }
+
+      calls.pop_back();
+      if (!calls.empty()) {
+        int u = calls.back().first;
+        if (lowlink[v] < lowlink[u]) lowlink[u] = lowlink[v];
+      }
+      if (lowlink[v] != index[v]) continue;
+
+      // v is the root of a component
+      intlist comp;
+      int w;
+      do {
+        w = stack.back();
+        stack.pop_back();
+        onstack[w] = false;
+        comp.push_back(w);
+      } while (w != v);
+      if (comp.size() > 1 || graph[v][v]) {
+        sort(comp.begin(), comp.end());
+        result.push_back(comp);
+      }
     }
   }
 }
 
 DPSet DependencyGraph :: get_scc() {
   DPSet ret;
-
-  if (reachable.size() != pairs.size()) calculate_reachable();
-  int i;
-  // for a given point i that is on a cycle, the SCC containing i
-  // consists of all dependency pairs which can be reached from i and
-  // from which i can be reached
-  for (i = 0; i < pairs.size() && !reachable[i][i]; i++);
-  if (i == pairs.size()) return ret;
-  for (int j = 0; j < pairs.size(); j++) {
-    if (reachable[i][j] && reachable[j][i]) ret.push_back(pairs[j]);
-  }
+  if (components.size() == 0) return ret;
+  for (int i = 0; i < components[0].size(); i++)
+    ret.push_back(pairs[components[0][i]]);
   return ret;
 }
 
 void DependencyGraph :: remove_pairs(DPSet &dps) {
-  vector<int> toremove;
+  vector<bool> removed(pairs.size(), false);
   int i, j;
 
   for (i = 0; i < dps.size(); i++)
     for (j = 0; j < pairs.size(); j++)
-      if (pairs[j] == dps[i]) toremove.push_back(j);
+      if (pairs[j] == dps[i] && pairs[j] != NULL) removed[j] = true;
 
-  for (i = 0; i < toremove.size(); i++) {
-    int k = toremove[i];
-    pairs[k] = NULL;
+  for (i = 0; i < pairs.size(); i++) {
+    if (!removed[i]) continue;
+    pairs[i] = NULL;
+    successors[i].clear();
     for (j = 0; j < pairs.size(); j++) {
-      graph[k][j] = false;
-      graph[j][k] = false;
+      graph[i][j] = false;
+      graph[j][i] = false;
     }
   }
 
-  calculate_reachable();
+  // components without removed pairs are unaffected; the others may
+  // fall apart, so we only recalculate within them
+  vector<intlist> updated;
+  for (i = 0; i < components.size(); i++) {
+    intlist remaining;
+    for (j = 0; j < components[i].size(); j++) {
+      if (!removed[components[i][j]]) remaining.push_back(components[i][j]);
+    }
+    if (remaining.size() == components[i].size())
+      updated.push_back(components[i]);
+    else find_components(remaining, updated);
+  }
+  sort(updated.begin(), updated.end(), component_less);
+  components = updated;
 }
 
 vector<DPSet> DependencyGraph :: get_sccs() {
   vector<DPSet> ret;
-  vector<int> redo;
-  int i, j;
-
-  DPSet scc = get_scc();
-  while (scc.size() > 0) {
-    // find the indexes of the SCC elements, and set them as
-    // not self-reachable (which will make sure they do not get
-    // chosen for the next scc), while also storing these numbers
-    // in redo (which will make sure they get put back correctly)
-    for (i = 0; i < pairs.size(); i++) {
-      for (j = 0; j < scc.size(); j++) {
-        if (pairs[i] == scc[j]) {
-          reachable[i][i] = false;
-          redo.push_back(i);
-        }
-      }
-    }
+  for (int i = 0; i < components.size(); i++) {
+    DPSet scc;
+    for (int j = 0; j < components[i].size(); j++)
+      scc.push_back(pairs[components[i][j]]);
     ret.push_back(scc);
-    scc = get_scc();
   }
-
-  // all elements of an scc should be self-reachable!
-  for (i = 0; i < redo.size(); i++)
-    reachable[redo[i]][redo[i]] = true;
-
   return ret;
 }
 
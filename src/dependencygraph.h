@@ -21,8 +21,30 @@
 #include "typer.h"
 #include "matchrule.h"
 
+#define GRAPH_MAX_THREADS 8
+  // the maximum number of threads used to estimate the graph
+#define GRAPH_PARALLEL_MINIMUM 256
+  // below this number of edges to be checked, no threads are started
+
 typedef vector<bool> graph_entry;
 typedef vector<int> intlist;
+typedef vector<unsigned long> bitrow;
+
+/**
+ * The parts of a graph estimation which depend only on the rules, and
+ * the edges found so far, for reuse by every graph built over the same
+ * ruleset.  Edges are indexed by the identities of the dependency
+ * pairs, which are preserved when pairs are copied into subproblems.
+ */
+struct EdgeCache {
+  bool filled;
+  map<string,graph_entry> noneatingpos;
+  map<string,int> symbol_index;
+  vector<bitrow> can_reduce_to;
+  map<pair<int,int>,bool> edges;
+
+  EdgeCache() :filled(false) {}
+};
 
 class DependencyGraph {
   private:
@@ -32,14 +54,20 @@ class DependencyGraph {
     vector<DependencyPair*> pairs;
       // given (not copied) from the ones in the dependency framework
     vector<graph_entry> graph;
-    vector<graph_entry> reachable;
+    vector<intlist> successors;
+      // successors[i] lists all j such that graph[i][j] holds
+    vector<intlist> components;
+      // the non-trivial strongly connected components of the graph,
+      // each sorted, and ordered by their smallest element
     map<string,graph_entry> noneatingpos;
       // noneatingpos[f,i] is true if a variable occurring somewhere
       // in the i^th argument of f cannot be reduced away
-    map<string,bool> can_reduce_to;
-      // can_reduce_to[f : g] is true if a term headed by symbol f
-      // can reduce to a term headed by symbol g; f must be a function
-      // symbol, but g may also be #ABS or #VAR
+    map<string,int> symbol_index;
+      // numbers the function symbols, for use in can_reduce_to
+    vector<bitrow> can_reduce_to;
+      // bit j of can_reduce_to[i] is set if a term headed by symbol i
+      // can reduce to a term headed by symbol j; the two columns after
+      // the last symbol stand for #ABS and #VAR
 
     bool is_constructor(PTerm symbol);
       // returns whether the given symbol is a constructor
@@ -49,12 +77,22 @@ class DependencyGraph {
       // splits an application into its components
     bool connection_possible(DependencyPair *p1, DependencyPair *p2);
       // returns true if the dependency graph approximation should
-      // have an edge from p1 to p2
+      // have an edge from p1 to p2; this only reads the graph, so may
+      // be called from several threads at once
+    void estimate_edges(vector< pair<int,int> > &todo,
+                        vector<char> &result);
+      // sets result[k] to connection_possible for the k^th pair of
+      // indexes in todo, spreading the work over several threads
+    static void *edge_worker(void *job);
+      // thread function for estimate_edges
     bool reduction_possible(PTerm from, PTerm to,
-                            DependencyPair *to_source);
+                            DependencyPair *to_source,
+                            map<int,int> &bound);
       // returns true if there might be a reduction from an
       // instantiation of from to an instantiation of to (gives false
-      // positives, but no false negatives)
+      // positives, but no false negatives); bound maps the variables
+      // bound above to to those bound at the same place above from,
+      // so no terms need to be built (which would not be thread-safe)
     Varset get_certain_variables(PTerm term,
                                  DependencyPair *dp);
       // returns all variables (not meta-variables) occurring inside
@@ -67,16 +105,25 @@ class DependencyGraph {
     void get_eating_info(Alphabet &Sigma);
       // fill the noneatingpos mapping
     void get_reduction_info(Alphabet &Sigma);
-      // fill the can_reduce_to mapping
+      // fill the can_reduce_to matrix
+    bool reduces_to(string f, string g);
+      // returns whether a term headed by f can reduce to a term headed
+      // by g, where g may also be #ABS or #VAR
 
     /* ============= determining cycles in the graph ============= */
     
-    void calculate_reachable();
-      // fill the reachable array, so reachable[i][j] is true if
-      // there is a path from i to j in the array
+    void calculate_sccs();
+      // fill the components list for the whole graph
+    void find_components(intlist &nodes, vector<intlist> &result);
+      // uses Tarjan's algorithm to find the strongly connected
+      // components of the subgraph with the given nodes, and adds
+      // those which contain at least one edge to result
 
   public:
-    DependencyGraph(Alphabet &Sigma, DPSet &P, vector<MatchRule*> &R);
+    DependencyGraph(Alphabet &Sigma, DPSet &P, vector<MatchRule*> &R,
+                    EdgeCache *cache = NULL);
+      // if a cache is given, it must always be used with the same
+      // Sigma and R; it is used both to look up and to store results
 
     string to_string();
       // debug functionality
@@ -95,13 +142,12 @@ class DependencyGraph {
       // returns a single strongly connected component
 
     vector<DPSet> get_sccs();
-      // returns all strongly connected components; if keep_graph is
-      // false, this is a bit more efficient, but the graph cannot be
-      // reused afterwards
+      // returns all strongly connected components
 
     void remove_pairs(DPSet &pairs);
       // should be the same pairs as returned by get_scc or get_sccs
-      // (or a subset), not copies!
+      // (or a subset), not copies!  Only the components containing
+      // removed pairs are recalculated.
 };
 
 #endif
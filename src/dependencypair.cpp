@@ -17,8 +17,11 @@
 #include "dependencypair.h"
 #include "environment.h"
 
+int DependencyPair :: next_identity = 0;
+
 DependencyPair :: DependencyPair(PTerm _left, PTerm _right, int _style)
-    :left(_left), right(_right), style(_style) {
+    :left(_left), right(_right), style(_style),
+     identity(next_identity++) {
 }
 
 DependencyPair :: ~DependencyPair() {
@@ -27,7 +30,10 @@ DependencyPair :: ~DependencyPair() {
 }
 
 DependencyPair *DependencyPair :: copy() {
-  return new DependencyPair(left->copy(), right->copy(), style);
+  DependencyPair *ret =
+    new DependencyPair(left->copy(), right->copy(), style);
+  ret->identity = identity;
+  return ret;
 }
 
 PTerm DependencyPair :: query_left() {
@@ -57,6 +63,7 @@ string DependencyPair :: to_string(bool showtypes) {
 void DependencyPair :: set_noneating(int Z, int pos) {
   if (pos >= 31) return;
   noneating[Z] |= (1 << pos);
+  identity = next_identity++;
 }
 
 bool DependencyPair :: query_noneating(int Z, int pos) {
@@ -72,9 +79,13 @@ map<int,int> DependencyPair :: query_noneating_mapping() {
 void DependencyPair :: set_headmost(bool value) {
   if (value) style = 1;
   else style = 0;
+  identity = next_identity++;
 }
 
 bool DependencyPair :: query_headmost() {
   return style == 1;
 }
 
+int DependencyPair :: query_identity() {
+  return identity;
+}
@@ -31,6 +31,12 @@ class DependencyPair {
     map<int,int> noneating;
       // restrictions: Z is non-eating at position k if bit k is set
       // in noneating[Z]
+    int identity;
+      // shared by a pair and all its copies, so results computed for
+      // one can be reused for the others; changing the pair gives it a
+      // new identity
+
+    static int next_identity;
 
   public:
     DependencyPair(PTerm _left, PTerm _right, int _style = 0);
@@ -45,6 +51,7 @@ class DependencyPair {
     map<int,int> query_noneating_mapping();
     void set_headmost(bool value);
     bool query_headmost();
+    int query_identity();
 };
 
 typedef vector<DependencyPair*> DPSet;
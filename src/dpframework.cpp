@@ -19,14 +19,17 @@
 #include "environment.h"
 #include "horpo.h"
 #include "outputmodule.h"
+#include "parallel.h"
 #include "polymodule.h"
 #include "subcritchecker.h"
 #include "substitution.h"
 #include "term.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 /* ================ initialising and destructing ================= */
 
@@ -42,10 +45,22 @@ DependencyFramework :: DependencyFramework(Alphabet &Sigma,
        allow_product_polynomials(true), allow_usable(true),
        allow_formative(true), allow_uwrt(true), allow_fwrt(true),
        splitter(Sigma, rules, FOtool, FOnontool),
-       found_counterexample(false), FOstatus(0), expanded(false) {
+       found_counterexample(false), FOstatus(0), expanded(false),
+       workers(1), in_worker(false), index_stride(1), index_residue(0),
+       shared_rulesets(0), stage_products(false),
+       staged_products(NULL), staged_problem(NULL) {
 
   int i;
 
+  // the default strategy is a known-good string, so parsing succeeds
+  string error;
+  default_strategy = Strategy::parse(DEFAULT_DP_STRATEGY, DP_STRATEGY,
+                                     error);
+  default_redpair = Strategy::parse(DEFAULT_REDPAIR_STRATEGY,
+                                    REDPAIR_STRATEGY, error);
+  strategy = default_strategy;
+  solved = &own_solved;
+
   // copy constants
   vector<string> constants = Sigma.get_all();
   for (i = 0; i < constants.size(); i++)
@@ -87,26 +102,81 @@ DependencyFramework :: DependencyFramework(Alphabet &Sigma,
 
 DependencyFramework :: ~DependencyFramework() {
   free_memory();
+  delete default_strategy;
+  delete default_redpair;
 }
 
 void DependencyFramework :: free_memory() {
-  int i, j;
-  for (i = 0; i < Ps.size(); i++) {
-    for (j = 0; j < Ps[i].size(); j++)
-      delete Ps[i][j];
+  int i;
+  for (map<DependencyPair*,int>::iterator it = pairusers.begin();
+       it != pairusers.end(); it++) {
+    delete it->first;
   }
+  pairusers.clear();
   Ps.clear();
-  for (i = 0; i < Rs.size(); i++) {
-    for (j = 0; j < Rs[i].size(); j++)
-      delete Rs[i][j];
+  Pusers.clear();
+  // rule sets may share rules, so free each rule only once
+  set<MatchRule*> rules;
+  for (i = 0; i < Rs.size(); i++)
+    rules.insert(Rs[i].begin(), Rs[i].end());
+  for (set<MatchRule*>::iterator it = rules.begin(); it != rules.end();
+       it++) {
+    delete *it;
   }
   Rs.clear();
+  edgecaches.clear();
+  symboldeps.clear();
+  usablecache.clear();
+  formativecache.clear();
   for (i = 0; i < problems.size(); i++) {
     delete problems[i];
   }
   problems.clear();
 }
 
+int DependencyFramework :: new_set_index(int size) {
+  while (size % index_stride != index_residue) size++;
+  return size;
+}
+
+int DependencyFramework :: add_pairset(DPSet &pairs) {
+  for (int i = 0; i < pairs.size(); i++) pairusers[pairs[i]]++;
+  int index = new_set_index(Ps.size());
+  Ps.resize(index);
+  Pusers.resize(index);
+  Ps.push_back(pairs);
+  Pusers.push_back(0);
+  return index;
+}
+
+DependencyFramework :: DPProblem *DependencyFramework :: new_problem(
+                                                  int P, int R) {
+  Pusers[P]++;
+  return new DPProblem(P, R);
+}
+
+void DependencyFramework :: delete_problem(DPProblem *prob) {
+  int P = prob->P;
+  delete prob;
+  if (--Pusers[P] > 0) return;
+
+  for (int i = 0; i < Ps[P].size(); i++) {
+    map<DependencyPair*,int>::iterator it = pairusers.find(Ps[P][i]);
+    if (--(it->second) > 0) continue;
+    delete it->first;
+    pairusers.erase(it);
+  }
+  DPSet().swap(Ps[P]);
+}
+
+void DependencyFramework :: free_unshared(Ruleset &rules,
+                                          Ruleset &shared) {
+  for (int i = 0; i < rules.size(); i++) {
+    if (find(shared.begin(), shared.end(), rules[i]) == shared.end())
+      delete rules[i];
+  }
+}
+
 /* ========================== settings =========================== */
 
 void DependencyFramework :: disable_graph() {
@@ -149,6 +219,18 @@ void DependencyFramework :: disable_abssimple() {
   abstraction_simple = false;
 }
 
+void DependencyFramework :: set_workers(int number) {
+  workers = number;
+}
+
+void DependencyFramework :: set_strategy(Strategy *_strategy) {
+  strategy = _strategy;
+}
+
+void DependencyFramework :: set_solved_cache(SolvedCache *cache) {
+  solved = cache;
+}
+
 /* ================== creating dependency pairs ================== */
 
 PTerm DependencyFramework :: up(PTerm term) {
@@ -419,9 +501,9 @@ void DependencyFramework :: setup(bool skipFO) {
   }
 
   // and initialise the very first dependency pair problem!
-  Ps.push_back(DP);
+  add_pairset(DP);
   Rs.push_back(R);
-  problems.push_back(new DPProblem(0,0));
+  problems.push_back(new_problem(0,0));
 }
 
 void DependencyFramework :: user_information() {
@@ -591,51 +673,263 @@ void DependencyFramework :: list_problems() {
 }
 
 bool DependencyFramework :: termination_loop() {
-  bool graph_optimal = false;
+  if (!process_problems(true, false)) return false;
+
+  wout.print("As all dependency pair problems were succesfully "
+    "simplified with sound (and complete) processors until nothing "
+    "remained, we conclude termination.\n");
+
+  return true;
+}
 
+bool DependencyFramework :: process_problems(bool announce,
+                                             bool graph_optimal) {
   // always problems 0..current-1 are assumed to be graph-optimal,
   // but perhaps the last problem is not, yet
   while (problems.size() > 0) {
-    list_problems();
+    if (announce) list_problems();
+    announce = true;
+    if (workers > 1 && !in_worker && problems.size() > 1 &&
+        !wout.query_verbose()) {
+      return parallel_processing(graph_optimal);
+    }
+
     DPProblem *prob = problems[problems.size()-1];
     problems.pop_back();
     wout.print("We consider the dependency pair problem " +
       print_problem_brief(prob) + ".\n");
 
     int old_size = problems.size();
-    bool unsetoptimal = false;
-
-    if (!graph_optimal && graph_processor(prob)) graph_optimal = true;
-    else if (empty_processor(prob)) {}
-    else if (subcrit_processor(prob)) unsetoptimal = true;
-    else if (static_processor(prob)) unsetoptimal = true;
-    else if (formative_processor(prob)) unsetoptimal = true;
-    else if (redpair_processor(prob)) unsetoptimal = true;
-    
-    else {
+    string step;
+
+    if (!apply_strategy(strategy, prob, graph_optimal, step)) {
       problems.push_back(prob);
       wout.verbose_print("Unfortunately, none of the methods we "
         "attempted could succeed in simplifying this problem.\n");
       return false;
     }
-    if (unsetoptimal && problems.size() != old_size)
+    if (step == "graph") graph_optimal = true;
+    else if (step != "empty" && problems.size() != old_size)
       graph_optimal = false;
-    delete prob;
+    delete_problem(prob);
   }
 
-  wout.print("As all dependency pair problems were succesfully "
-    "simplified with sound (and complete) processors until nothing "
-    "remained, we conclude termination.\n");
+  return true;
+}
+
+bool DependencyFramework :: parallel_processing(bool last_optimal) {
+  vector<DPProblem*> todo = problems;
+  problems.clear();
+  int n = todo.size();
+  vector<string> outputs(n);
+  vector<bool> solved(n, false);
+  vector<bool> handled_here(n, false);
+  vector<DPProblem*> leftover;
+    // the unsolved problems remaining from a problem handled here
+  int failed = -1;
+
+  // start workers from the last problem down, as process_problems
+  // would consider them; as soon as one fails, the rest are useless
+  WorkerPool pool(workers);
+  int next = n - 1;
+  while (true) {
+    while (failed == -1 && next >= 0 && !pool.full()) {
+      bool worker = pool.start(next);
+      if (worker || pool.take_failure(next)) {
+        // a problem which could not be given to a worker is handled
+        // here, but numbers its sets as the worker would have
+        bool was_in_worker = in_worker;
+        int old_stride = index_stride, old_residue = index_residue;
+        int old_shared = shared_rulesets;
+        index_stride = n;
+        index_residue = n - 1 - next;
+        shared_rulesets = Rs.size();
+        in_worker = true;
+        problems.push_back(todo[next]);
+        wout.mark_progress();
+        bool ok = process_problems(false, next < n - 1 || last_optimal);
+        if (worker) WorkerPool::finish(ok, wout.export_progress());
+        // process_problems has already deleted or kept the problem
+        outputs[next] = wout.take_progress();
+        solved[next] = ok;
+        handled_here[next] = true;
+        if (!ok) leftover = problems;
+        problems.clear();
+        in_worker = was_in_worker;
+        index_stride = old_stride;
+        index_residue = old_residue;
+        shared_rulesets = old_shared;
+        if (!ok) {
+          failed = next;
+          pool.cancel();
+        }
+      }
+      next--;
+    }
+
+    int task;
+    bool success;
+    string data;
+    if (!pool.wait(task, success, data)) break;
+    outputs[task] = data;
+    solved[task] = success;
+    if (!success && failed == -1) {
+      failed = task;
+      pool.cancel();
+    }
+  }
+
+  if (failed != -1) {
+    wout.import_progress(outputs[failed]);
+    for (int i = 0; i < n; i++) {
+      if (handled_here[i]) continue;
+      if (solved[i]) delete_problem(todo[i]);
+      else problems.push_back(todo[i]);
+    }
+    problems.insert(problems.end(), leftover.begin(), leftover.end());
+    return false;
+  }
 
+  for (int i = n - 1; i >= 0; i--) {
+    wout.import_progress(outputs[i]);
+    if (!handled_here[i]) delete_problem(todo[i]);
+  }
   return true;
 }
 
+bool DependencyFramework :: apply_strategy(Strategy *how,
+                                           DPProblem *prob,
+                                           bool graph_optimal,
+                                           string &step) {
+  if (how->kind == STRATEGY_CHOICE) {
+    for (int i = 0; i < how->parts.size(); i++) {
+      if (apply_strategy(how->parts[i], prob, graph_optimal, step))
+        return true;
+    }
+    return false;
+  }
+
+  // a sequence applies each part to whatever the previous parts left
+  // of prob, and repetition does so for as long as there is an effect
+  if (how->kind == STRATEGY_SEQUENCE || how->kind == STRATEGY_REPEAT) {
+    vector<DPProblem*> current(1, prob);
+    bool any = false;
+    if (how->kind == STRATEGY_SEQUENCE) {
+      for (int i = 0; i < how->parts.size(); i++) {
+        if (apply_to_all(how->parts[i], current, prob,
+                         graph_optimal && !any, step)) any = true;
+      }
+    }
+    else while (apply_to_all(how->parts[0], current, prob,
+                             graph_optimal && !any, step)) any = true;
+    if (any) problems.insert(problems.end(), current.begin(), current.end());
+    return any;
+  }
+
+  // budgets and races are done in worker processes; as the output
+  // cannot be shown while working, verbose mode works sequentially
+  if (how->kind == STRATEGY_BUDGET || how->kind == STRATEGY_RACE) {
+    if (wout.query_verbose()) {
+      for (int i = 0; i < how->parts.size(); i++) {
+        if (apply_strategy(how->parts[i], prob, graph_optimal, step))
+          return true;
+      }
+      return false;
+    }
+    int limit = how->kind == STRATEGY_BUDGET ? how->seconds * 1000 : -1;
+    return dp_workers(how->parts, prob, graph_optimal, limit, step);
+  }
+
+  bool success = false;
+  if (how->name == "graph")
+    success = !graph_optimal && graph_processor(prob);
+  else if (how->name == "empty") success = empty_processor(prob);
+  else if (how->name == "subcrit") success = subcrit_processor(prob);
+  else if (how->name == "static") success = static_processor(prob);
+  else if (how->name == "formative")
+    success = formative_processor(prob);
+  else if (how->name == "redpair") {
+    Strategy *inner = default_redpair;
+    if (how->parts.size() > 0) inner = how->parts[0];
+    success = redpair_processor(prob, inner);
+  }
+  if (success) step = how->name;
+  return success;
+}
+
+bool DependencyFramework :: apply_to_all(Strategy *how,
+                                         vector<DPProblem*> &current,
+                                         DPProblem *original,
+                                         bool graph_optimal,
+                                         string &step) {
+  bool any = false;
+  vector<DPProblem*> result;
+  for (int i = 0; i < current.size(); i++) {
+    int old_size = problems.size();
+    if (!apply_strategy(how, current[i], graph_optimal, step)) {
+      result.push_back(current[i]);
+      continue;
+    }
+    any = true;
+    result.insert(result.end(), problems.begin() + old_size,
+                  problems.end());
+    problems.resize(old_size);
+    if (current[i] != original) delete_problem(current[i]);
+  }
+  current = result;
+  return any;
+}
+
+bool DependencyFramework :: dp_workers(vector<Strategy*> &options,
+                                       DPProblem *prob,
+                                       bool graph_optimal, int limit,
+                                       string &step) {
+  int i, n = options.size();
+  WorkerPool pool(n);
+  for (i = 0; i < n; i++) {
+    if (!pool.start(i)) continue;
+    // worker: only report whether the strategy succeeds, as its
+    // result is spread over new problems and sets, which cannot
+    // easily be passed back; the main process repeats it instead
+    bool ok = apply_strategy(options[i], prob, graph_optimal, step);
+    WorkerPool::finish(ok, "");
+  }
+
+  // options for which no worker could be forked are done here, as a
+  // choice would do them (without a time limit)
+  for (i = 0; i < n; i++) {
+    if (!pool.take_failure(i)) continue;
+    if (apply_strategy(options[i], prob, graph_optimal, step)) {
+      pool.cancel();
+      return true;
+    }
+  }
+
+  long deadline = limit < 0 ? -1 : WorkerPool::milliseconds() + limit;
+  int task;
+  bool success;
+  string data;
+  while (true) {
+    int remaining = -1;
+    if (deadline >= 0) {
+      remaining = deadline - WorkerPool::milliseconds();
+      if (remaining < 0) remaining = 0;
+    }
+    if (!pool.wait(task, success, data, remaining)) return false;
+    if (success) break;
+  }
+  pool.cancel();
+
+  return apply_strategy(options[task], prob, graph_optimal, step);
+}
+
 /* ================== dependency pair processors ================= */
 
 bool DependencyFramework :: graph_processor(DPProblem *prob) {
   if (!allow_graph) return false;
 
-  DependencyGraph graph(F, Ps[prob->P], Rs[prob->R]);
+  DependencyGraph graph(F, Ps[prob->P], Rs[prob->R],
+                        &edgecaches[prob->R]);
   vector<DPSet> sccs = graph.get_sccs();
 
   if (sccs.size() == 1 && sccs[0].size() == Ps[prob->P].size()) {
@@ -664,13 +958,11 @@ bool DependencyFramework :: graph_processor(DPProblem *prob) {
   string Rstring = "R_" + wout.str(prob->R);
   int i;
   for (i = 0; i < sccs.size(); i++) {
-    int Pnum = Ps.size();
+    int Pnum = new_set_index(Ps.size());
     wout.print("P_" + wout.str(Pnum) + ":\n");
     wout.print_DPs(sccs[i], F, arities, false);
-    for (int j = 0; j < sccs[i].size(); j++)
-      sccs[i][j] = sccs[i][j]->copy();
-    Ps.push_back(sccs[i]);
-    problems.push_back(new DPProblem(Pnum, prob->R));
+    add_pairset(sccs[i]);
+    problems.push_back(new_problem(Pnum, prob->R));
     string probstring = "(P_" + wout.str(Pnum) + ", " + Rstring + ", m, f)";
     if (i == 0) newprobs = probstring;
     else if (i == sccs.size()-1) newprobs += " and " + probstring;
@@ -721,21 +1013,16 @@ bool DependencyFramework :: subcrit_processor(DPProblem *prob) {
       "immediately removed.\n");
   }
   else {
-    DPSet newset;
-    for (int i = 0; i < equal.size(); i++) {
-      newset.push_back(equal[i]->copy());
-    }
-    int num = Ps.size();
-    Ps.push_back(newset);
+    int num = add_pairset(equal);
     
     string newPstring = "P_" + wout.str(num);
     wout.print("By " + theorem + ", we may replace a dependency pair "
       "problem (" + Pstring + ", " + Rstring + ", " + minflag + ", f) "
       "by (" + newPstring + ", " + Rstring + ", " + minflag + ", f), "
       "where " + newPstring + " contains:\n");
-    wout.print_DPs(newset, F, arities, false);
+    wout.print_DPs(equal, F, arities, false);
 
-    problems.push_back(new DPProblem(num, prob->R));
+    problems.push_back(new_problem(num, prob->R));
   }
 
   return true;
@@ -762,44 +1049,79 @@ bool DependencyFramework :: static_processor(DPProblem *prob) {
       "Thm. 7.15") + " this problem may be immediately removed.\n");
   }
   else {
-    DPSet newset;
-    for (int i = 0; i < equal.size(); i++) {
-      newset.push_back(equal[i]->copy());
-    }
-    int num = Ps.size();
-    Ps.push_back(newset);
+    int num = add_pairset(equal);
     
     string newPstring = "P_" + wout.str(num);
     wout.print("By " + wout.cite("FuhKop19", "Thm. 7.6") + ", we may "
       "replace a dependency pair problem (" + Pstring + ", " +
       Rstring + ", computable, f) by (" + newPstring + ", " + Rstring +
       ", computable, f), where " + newPstring + " contains:\n");
-    wout.print_DPs(newset, F, arities, false);
+    wout.print_DPs(equal, F, arities, false);
 
-    problems.push_back(new DPProblem(num, prob->R));
+    problems.push_back(new_problem(num, prob->R));
   }
 
   return true;
 }
 
-bool DependencyFramework :: formative_processor(DPProblem *prob) {
-  if (!allow_formative || !formative_flag) return false;
+SymbolDependencies *DependencyFramework :: rule_dependencies(int R) {
+  map<int,SymbolDependencies>::iterator it = symboldeps.find(R);
+  if (it != symboldeps.end()) return &it->second;
+  SymbolDependencies &deps = symboldeps[R];
+  manip.symbol_dependencies(Rs[R], deps);
+  return &deps;
+}
+
+Ruleset DependencyFramework :: usable_rules(DPProblem *prob) {
+  pair<int,int> key(prob->P, prob->R);
+  map< pair<int,int>, Ruleset >::iterator it = usablecache.find(key);
+  if (it != usablecache.end()) return it->second;
+  Ruleset UR = manip.usable_rules(Ps[prob->P], Rs[prob->R],
+                                  rule_dependencies(prob->R));
+  usablecache[key] = UR;
+  return UR;
+}
+
+int DependencyFramework :: formative_index(DPProblem *prob,
+                                           bool &added) {
+  pair<int,int> key(prob->P, prob->R);
+  added = false;
+  map< pair<int,int>, int >::iterator it = formativecache.find(key);
+  if (it != formativecache.end()) return it->second;
 
   int i, j;
 
   // calculate formative rules, abort if they're just the same as the
   // usual rules
   Ruleset R = Rs[prob->R];
-  Ruleset FR = manip.formative_rules(Ps[prob->P], R);
+  Ruleset FR = manip.formative_rules(Ps[prob->P], R,
+                                     rule_dependencies(prob->R));
   if (FR.size() == R.size()) {
     for (i = 0; i < FR.size(); i++) delete FR[i];
-    return false;
+    formativecache[key] = -1;
+    return -1;
+  }
+
+  // formative rules which are unchanged are shared with R; as they
+  // are found in the same order, we only need to search forward
+  for (i = 0, j = 0; i < FR.size(); i++) {
+    for (int k = j; k < R.size(); k++) {
+      if (FR[i]->query_left_side()->equals(R[k]->query_left_side()) &&
+          FR[i]->query_right_side()->equals(R[k]->query_right_side())) {
+        delete FR[i];
+        FR[i] = R[k];
+        j = k + 1;
+        break;
+      }
+    }
   }
 
   // determine whether we've seen this set of formative rules before;
   // if not, just add it to the Rs list
   int FRnum = -1;
   for (i = 0; i < Rs.size() && FRnum == -1; i++) {
+    if (i >= shared_rulesets && i % index_stride != index_residue)
+      continue;
     if (Rs[i].size() != FR.size()) continue;
     bool equal = true;
     for (j = 0; j < FR.size() && equal; j++) {
@@ -812,14 +1134,24 @@ bool DependencyFramework :: formative_processor(DPProblem *prob) {
     }
     if (equal) FRnum = i;
   }
-  bool added = FRnum == -1;
+  added = FRnum == -1;
   if (FRnum == -1) {
-    FRnum = Rs.size();
+    FRnum = new_set_index(Rs.size());
+    Rs.resize(FRnum);
     Rs.push_back(FR);
   }
-  else {
-    for (i = 0; i < FR.size(); i++) delete FR[i];
-  }
+  else free_unshared(FR, R);
+
+  formativecache[key] = FRnum;
+  return FRnum;
+}
+
+bool DependencyFramework :: formative_processor(DPProblem *prob) {
+  if (!allow_formative || !formative_flag) return false;
+
+  bool added;
+  int FRnum = formative_index(prob, added);
+  if (FRnum == -1) return false;
 
   // tell the user what we've been doing!
   if (Rs[FRnum].size() == 0) {
@@ -837,7 +1169,7 @@ bool DependencyFramework :: formative_processor(DPProblem *prob) {
     wout.print_rules(Rs[FRnum], F, arities);
   }
 
-  DPProblem *newprob = new DPProblem(prob->P, FRnum);
+  DPProblem *newprob = new_problem(prob->P, FRnum);
   problems.push_back(newprob);
 
   wout.print("By " + wout.cite("Kop12", "Thm. 7.17") + ", we may "
@@ -870,13 +1202,12 @@ void DependencyFramework :: add_reduced_problem(DPProblem *prob,
     DPSet Pnew;
     for (i = 0; i < Ps[prob->P].size(); i++) {
       if (removed.find(i) != removed.end()) continue;
-      Pnew.push_back(Ps[prob->P][i]->copy());
+      Pnew.push_back(Ps[prob->P][i]);
     }
-    int Pnum = Ps.size();
-    Ps.push_back(Pnew);
+    int Pnum = add_pairset(Pnew);
 
     // determine the new problem
-    DPProblem *newprob = new DPProblem(Pnum, prob->R);
+    DPProblem *newprob = new_problem(Pnum, prob->R);
     problems.push_back(newprob);
     
     // and comment!
@@ -888,9 +1219,10 @@ void DependencyFramework :: add_reduced_problem(DPProblem *prob,
   }
 }
 
-bool DependencyFramework :: redpair_processor(DPProblem *prob) {
+bool DependencyFramework :: redpair_processor(DPProblem *prob,
+                                              Strategy *how) {
   Ruleset UR;
-  if (allow_usable) UR = manip.usable_rules(Ps[prob->P], Rs[prob->R]);
+  if (allow_usable) UR = usable_rules(prob);
   else UR = Rs[prob->R];
 
   bool tagged = formative_flag && abstraction_simple;
@@ -940,15 +1272,61 @@ bool DependencyFramework :: redpair_processor(DPProblem *prob) {
     // some restructuring, in that the requirements for orientation
     // must be added AFTER executing argument functions!
 
-  bool success = poly_processor(prob, op, false) ||
-                 horpo_processor(prob, op, false) ||
-                 (allow_product_polynomials && poly_processor(prob, op, true));
+  // if we have solved the same problem before, its proof still applies
+  string key = solved_key(prob, UR, op, how);
+  SolvedCache::iterator it = solved->find(key);
+  bool success = it != solved->end();
+  if (success) {
+    wout.import_progress(it->second.proof);
+    last_reduction = it->second.removed;
+  }
+  else {
+    wout.mark_progress();
+    success = apply_redpair_strategy(how, prob, op);
+    delete staged_products;
+    staged_products = NULL;
+    staged_problem = NULL;
+    string proof = wout.export_progress();
+    if (success) {
+      (*solved)[key].removed = last_reduction;
+      (*solved)[key].proof = proof;
+    }
+  }
+  if (success) add_reduced_problem(prob, last_reduction);
+
   delete op;
   if (success) wout.succeed_method("redpair");
   else wout.abort_method("redpair");
   return success;
 }
 
+string DependencyFramework :: solved_key(DPProblem *prob, Ruleset &UR,
+                                         DPOrderingProblem *ord,
+                                         Strategy *how) {
+  // the settings which influence the reduction pair processors
+  string key = how->to_string() + "\n";
+  key += (formative_flag && abstraction_simple) ? "tagged " : "";
+  key += allow_uwrt ? "uwrt " : "";
+  key += allow_fwrt ? "fwrt " : "";
+  key += allow_polynomials ? "poly " : "";
+  key += allow_product_polynomials ? "pprod " : "";
+  key += allow_horpo ? "horpo " : "";
+  key += "\n";
+  for (map<string,int>::iterator it = ord->arities.begin();
+       it != ord->arities.end(); it++) {
+    key += it->first + "/" + wout.str(it->second) + " ";
+  }
+
+  // the pairs and rules, with variables named in order of occurrence
+  int i;
+  for (i = 0; i < Ps[prob->P].size(); i++)
+    key += "\n" + Ps[prob->P][i]->to_string(true);
+  key += "\n";
+  for (i = 0; i < UR.size(); i++)
+    key += "\n" + UR[i]->to_string(true);
+  return key;
+}
+
 bool DependencyFramework :: poly_processor(DPProblem *prob,
                                DPOrderingProblem *ord, bool pprod) {
   if (!allow_polynomials) return false;
@@ -956,17 +1334,38 @@ bool DependencyFramework :: poly_processor(DPProblem *prob,
 
   wout.start_method("poly redpair");
 
-  // use polynomial interpretations
-  PolyModule pols;
-  pols.set_use_products(pprod);
-  vector<int> ok = pols.orient(ord);
+  // use polynomial interpretations; if the product-free attempt on
+  // this problem built its constraints with the products included, we
+  // can simply continue with that
+  PolyModule *pols;
+  vector<int> ok;
+  if (pprod && staged_products != NULL && staged_problem == ord) {
+    pols = staged_products;
+    staged_products = NULL;
+    ok = pols->enable_products();
+  }
+  else {
+    pols = new PolyModule;
+    pols->set_use_products(pprod || stage_products);
+    pols->set_delay_products(!pprod && stage_products);
+    pols->set_candidate(last_model);
+    ok = pols->orient(ord);
+  }
 
   if (ok.size() != 0) {
-    add_reduced_problem(prob, ok);
+    last_reduction = ok;
+    last_model = pols->query_model();
+    delete pols;
     wout.succeed_method("poly redpair");
     return true;
   }
   else {
+    if (!pprod && stage_products) {
+      delete staged_products;
+      staged_products = pols;
+      staged_problem = ord;
+    }
+    else delete pols;
     wout.verbose_print("Unfortunately, our attempt with POLY met "
       "with little succes.\n");
     wout.abort_method("poly redpair");
@@ -1027,7 +1426,7 @@ bool DependencyFramework :: horpo_processor(DPProblem *prob,
   ord->meta_extend_stricts();
 
   if (ok.size() != 0) {
-    add_reduced_problem(prob, ok);
+    last_reduction = ok;
     wout.succeed_method("horpo redpair");
     return true;
   }
@@ -1039,6 +1438,120 @@ bool DependencyFramework :: horpo_processor(DPProblem *prob,
   }
 }
 
+bool DependencyFramework :: apply_redpair_strategy(Strategy *how,
+                                  DPProblem *prob, DPOrderingProblem *ord) {
+  if (how->kind == STRATEGY_CHOICE) {
+    for (int i = 0; i < how->parts.size(); i++) {
+      // building the product monomials slows down the product-free
+      // attempt, so this is only done if pprod must follow it
+      stage_products = allow_polynomials && allow_product_polynomials &&
+        i+1 < how->parts.size() && how->parts[i]->is_step("poly") &&
+        how->parts[i+1]->is_step("pprod");
+      bool success = apply_redpair_strategy(how->parts[i], prob, ord);
+      stage_products = false;
+      if (success) return true;
+    }
+    return false;
+  }
+
+  // budgets and races are done in worker processes; as the output
+  // cannot be shown while working, verbose mode works sequentially
+  if (how->kind == STRATEGY_BUDGET || how->kind == STRATEGY_RACE) {
+    if (wout.query_verbose()) {
+      for (int i = 0; i < how->parts.size(); i++) {
+        if (apply_redpair_strategy(how->parts[i], prob, ord)) return true;
+      }
+      return false;
+    }
+    if (how->kind == STRATEGY_BUDGET)
+      return redpair_workers(how->parts, prob, ord, how->seconds * 1000);
+    return redpair_workers(how->parts, prob, ord, -1);
+  }
+
+  // steps
+  if (how->name == "poly") return poly_processor(prob, ord, false);
+  if (how->name == "horpo") return horpo_processor(prob, ord, false);
+  if (how->name == "pprod") {
+    return allow_product_polynomials && poly_processor(prob, ord, true);
+  }
+  return false;
+}
+
+bool DependencyFramework :: redpair_workers(vector<Strategy*> &options,
+                                            DPProblem *prob,
+                                            DPOrderingProblem *ord,
+                                            int limit) {
+  int n = options.size();
+  WorkerPool pool(n);
+  for (int i = 0; i < n; i++) {
+    if (!pool.start(i)) continue;
+    // worker: report the removed pairs, followed by the proof text
+    wout.mark_progress();
+    bool ok = apply_redpair_strategy(options[i], prob, ord);
+    string data = "";
+    for (int j = 0; ok && j < last_reduction.size(); j++)
+      data += wout.str(last_reduction[j]) + " ";
+    WorkerPool::finish(ok, data + "\n" + wout.export_progress());
+  }
+
+  // options for which no worker could be forked are done here, as a
+  // choice would do them (without a time limit, so only until one
+  // succeeds)
+  long deadline = limit < 0 ? -1 : WorkerPool::milliseconds() + limit;
+  int best = -1;
+  vector<int> bestremoved;
+  string bestoutput;
+  for (int i = 0; i < n; i++) {
+    if (!pool.take_failure(i) || best != -1) continue;
+    wout.mark_progress();
+    bool ok = apply_redpair_strategy(options[i], prob, ord);
+    string output = wout.take_progress();
+    if (!ok) continue;
+    best = i;
+    bestremoved = last_reduction;
+    bestoutput = output;
+  }
+
+  // wait for the first success, and give the others a little time to
+  // do better
+  if (best != -1) {
+    long grace = WorkerPool::milliseconds() + PORTFOLIO_GRACE;
+    if (deadline < 0 || grace < deadline) deadline = grace;
+  }
+  int task;
+  bool success;
+  string data;
+  while (true) {
+    int remaining = -1;
+    if (deadline >= 0) {
+      remaining = deadline - WorkerPool::milliseconds();
+      if (remaining < 0) remaining = 0;
+    }
+    if (!pool.wait(task, success, data, remaining)) break;
+    if (!success) continue;
+    if (best == -1) {
+      long grace = WorkerPool::milliseconds() + PORTFOLIO_GRACE;
+      if (deadline < 0 || grace < deadline) deadline = grace;
+    }
+    int k = data.find('\n');
+    vector<int> removed;
+    istringstream numbers(data.substr(0, k));
+    for (int pair; numbers >> pair; ) removed.push_back(pair);
+    if (best == -1 || removed.size() > bestremoved.size() ||
+        (removed.size() == bestremoved.size() && task < best)) {
+      best = task;
+      bestremoved = removed;
+      bestoutput = data.substr(k + 1);
+    }
+  }
+  pool.cancel();
+  if (best == -1) return false;
+
+  wout.import_progress(bestoutput);
+  last_reduction = bestremoved;
+  return true;
+}
+
 /* =================== non-termination analysis ================== */
 
 bool DependencyFramework :: first_order_non_terminating() {
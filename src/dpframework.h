@@ -14,12 +14,34 @@
    limitations under the License.
  *************************************************************************/
 
+#ifndef DPFRAMEWORK_H
+#define DPFRAMEWORK_H
+
 #include "dependencypair.h"
 #include "dependencygraph.h"
 #include "alphabet.h"
 #include "rulesmanipulator.h"
 #include "firstorder.h"
 #include "orderingproblem.h"
+#include "polymodule.h"
+#include "strategy.h"
+
+#define PORTFOLIO_GRACE 500
+  // when racing reduction pairs, the number of milliseconds the other
+  // strategies get to improve on the first success
+/**
+ * A reduction pair proof which was found for some DP problem: the
+ * indexes of the pairs it removes, and its explanation as exported by
+ * the output module.  Proofs are stored under a description of the
+ * problem which does not depend on variable names or on the numbering
+ * of the DP problems, so that the same problem can be recognised when
+ * it comes up again, also in another framework.
+ */
+struct SolvedProblem {
+  vector<int> removed;
+  string proof;
+};
+typedef map<string,SolvedProblem> SolvedCache;
 
 /**
  * This class implements the global dependency pair framework.
@@ -57,6 +79,24 @@ class DependencyFramework {
   private:
     vector<DPSet> Ps;
     vector<Ruleset> Rs;
+      // the sets which DP problems refer to; a set derived from
+      // another shares its elements rather than copying them, so the
+      // pairs and rules are never modified once they are in a set
+    vector<int> Pusers;
+      // Pusers[i] is the number of open problems using Ps[i]; when it
+      // drops to 0, the set is emptied
+    map<DependencyPair*,int> pairusers;
+      // for every pair, the number of sets in Ps containing it; pairs
+      // are freed as soon as no set refers to them anymore
+    map<int,EdgeCache> edgecaches;
+      // for every index in Rs, the graph estimation done so far
+    map<int,SymbolDependencies> symboldeps;
+      // for every index in Rs, how the symbols in its rules connect
+    map< pair<int,int>, Ruleset > usablecache;
+    map< pair<int,int>, int > formativecache;
+      // for every combination (Ps[i], Rs[j]) considered so far, the
+      // usable rules, and the index in Rs of the formative rules (or
+      // -1 if all rules are formative)
 
     class DPProblem {
       public:
@@ -100,6 +140,42 @@ class DependencyFramework {
     bool leftlinear;
     bool fullyextended;
     bool abstraction_simple;
+    int workers;
+      // the number of DP problems which may be handled at once
+    bool in_worker;
+      // set in a forked process which handles a single DP problem
+    int index_stride;
+    int index_residue;
+    int shared_rulesets;
+      // the indexes of new pair and rule sets are index_residue modulo
+      // index_stride; in the main process these are 1 and 0, but the
+      // workers started together each get their own residue, so the
+      // names in the combined proof are unique however many sets they
+      // create; rule sets from shared_rulesets on which do not have
+      // this residue belong to other workers, and are left empty
+    Strategy *strategy;
+      // the processors to apply to every DP problem
+    Strategy *default_strategy;
+    Strategy *default_redpair;
+      // owned by the framework, for when no strategy is given
+    vector<int> last_reduction;
+      // the pairs removed by the last reduction pair which succeeded
+    PolyModel last_model;
+      // the interpretation found by the last polynomial reduction pair
+      // which succeeded, which is tried first on the next problem
+    bool stage_products;
+    PolyModule *staged_products;
+    DPOrderingProblem *staged_problem;
+      // stage_products is set while running a poly step which is
+      // directly followed by pprod (as in poly | pprod); the
+      // product-free attempt then already includes product monomials
+      // (fixed to 0), and when it fails, its module is kept in
+      // staged_products, so the pprod step on the same staged_problem
+      // only needs to solve again
+    SolvedCache own_solved;
+    SolvedCache *solved;
+      // the reduction pair proofs found so far; by default this is
+      // own_solved, but it may be shared with other frameworks
 
     bool found_counterexample;
     string counterexample;
@@ -112,6 +188,20 @@ class DependencyFramework {
       // empties each of Ps, Rs and problems, and frees the memory
       // they use
 
+    int new_set_index(int size);
+      // returns the first index from size on which this process may
+      // give to a new pair or rule set
+    int add_pairset(DPSet &pairs);
+      // adds pairs to Ps (sharing the pairs with the sets they come
+      // from) and returns its index
+    DPProblem *new_problem(int P, int R);
+      // creates the problem (Ps[P], Rs[R])
+    void delete_problem(DPProblem *prob);
+      // frees prob, and empties Ps[prob->P] if no other problem uses
+      // it anymore
+    void free_unshared(Ruleset &rules, Ruleset &shared);
+      // frees those rules which do not also occur in shared
+
     void setup(bool skipFO);
       // having established all the properties (such as the static
       // flag and left-linearity of the system), calculates the
@@ -165,6 +255,17 @@ class DependencyFramework {
       // iterates over the current dependency pair problems, trying to
       // prove termination; returns true iff these attempts succeed
 
+    bool process_problems(bool announce, bool graph_optimal);
+      // the main part of termination_loop; if announce is false,
+      // then the problems are not listed before handling the first
+      // one, and if graph_optimal is true, then the graph processor
+      // is not applied to it
+
+    bool parallel_processing(bool last_optimal);
+      // handles all current problems at the same time, each in its
+      // own worker process; the outputs are added in the order in
+      // which process_problems would have considered the problems
+
     bool force_static_approach();
       // eta-expands the system and restarts the dependency pair
       // approach with static dependency pairs (if possible)
@@ -193,16 +294,64 @@ class DependencyFramework {
       // tries to apply the formative rules processor on the given DP
       // problem
 
-    bool redpair_processor(DPProblem *prob);
+    SymbolDependencies *rule_dependencies(int R);
+      // returns the symbol dependencies of Rs[R], calculating them
+      // the first time
+    Ruleset usable_rules(DPProblem *prob);
+      // returns the usable rules of prob (pointers into Rs[prob->R])
+    int formative_index(DPProblem *prob, bool &added);
+      // returns the index in Rs of the formative rules of prob, or -1
+      // if these are all the rules; added is set if the index was
+      // newly created
+
+    bool redpair_processor(DPProblem *prob, Strategy *how);
       // tries to apply the reduction pair processor, with horpo or
-      // polynomial interpretations, on the given DP problem
+      // polynomial interpretations as given by the reduction pair
+      // strategy how, on the given DP problem
+    string solved_key(DPProblem *prob, Ruleset &UR,
+                      DPOrderingProblem *ord, Strategy *how);
+      // returns the description of the given reduction pair problem
+      // under which its proof is stored in solved
 
     bool horpo_processor(DPProblem *prob, DPOrderingProblem *ord,
                          bool with_nasty_eta);
     bool poly_processor(DPProblem *prob, DPOrderingProblem *ord,
                         bool with_pprod);
-      // tries to apply either reduction pair processor on the given
-      // DP problem
+      // tries to orient the requirements in ord with either reduction
+      // pair; if this succeeds, the strictly oriented pairs are
+      // stored in last_reduction
+
+    bool apply_strategy(Strategy *how, DPProblem *prob,
+                        bool graph_optimal, string &step);
+      // applies the given dependency pair strategy to prob; returns
+      // true if this had any effect, and in that case sets step to
+      // the processor which succeeded last (the problems which
+      // replace prob are then added to problems)
+    bool apply_to_all(Strategy *how, vector<DPProblem*> &current,
+                      DPProblem *original, bool graph_optimal,
+                      string &step);
+      // applies the given strategy to each of current, replacing
+      // those for which it has any effect by their results; returns
+      // whether this happened for any of them (replaced problems are
+      // deleted, except for original, which the caller deletes)
+    bool dp_workers(vector<Strategy*> &options, DPProblem *prob,
+                    bool graph_optimal, int limit, string &step);
+      // runs the given dependency pair strategies on prob at the same
+      // time, each in its own worker process, and then applies the
+      // first to succeed here; if limit is non-negative, strategies
+      // which take longer than that many milliseconds are abandoned
+    bool apply_redpair_strategy(Strategy *how, DPProblem *prob,
+                                DPOrderingProblem *ord);
+      // applies the given reduction pair strategy to prob, with the
+      // requirements given by ord
+    bool redpair_workers(vector<Strategy*> &options, DPProblem *prob,
+                         DPOrderingProblem *ord, int limit);
+      // runs the given reduction pair strategies at the same time,
+      // each in its own worker process, and applies the result of
+      // the first to succeed, or of the one which removes the most
+      // pairs within PORTFOLIO_GRACE milliseconds of that; if limit
+      // is non-negative, the workers are cancelled when they have
+      // not succeeded after limit milliseconds
 
     void add_reduced_problem(DPProblem *prob, vector<int> &ok);
       // adds a new problem to the dependency pair list, which is
@@ -247,5 +396,13 @@ class DependencyFramework {
     void disable_fwrt();
     void disable_uwrt();
     void disable_abssimple();
+    void set_workers(int number);
+    void set_strategy(Strategy *strategy);
+      // the strategy should remain available while the framework is
+      // used, and is not freed by it
+    void set_solved_cache(SolvedCache *cache);
+      // shares the given store of reduction pair proofs with other
+      // frameworks; it is not freed by the framework
 };
 
+#endif
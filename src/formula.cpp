@@ -85,6 +85,15 @@ void Vars :: reset_valuation() {
     force_value(i, UNKNOWN);
 }
 
+void Vars :: truncate(unsigned int size) {
+  if (size < 2) size = 2;
+  if (size < val.size()) {
+    val.resize(size);
+    descriptions.resize(size);
+  }
+  reset_valuation();
+}
+
 int Vars :: false_var() { return 0; }
 int Vars :: true_var() { return 1; }
 
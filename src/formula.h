@@ -55,6 +55,10 @@ class Vars {
     void reset_valuation();
       // sets the valuation of all variables (except true and false)
       // to UNKNOWN, but does keep them in the varset
+    void truncate(unsigned int size);
+      // removes all variables with index size or higher, and sets
+      // the valuation of the others (except true and false) to
+      // UNKNOWN
 };
 
 extern Vars vars;
@@ -39,18 +39,33 @@ vector<int> Horpo :: orient(OrderingProblem *prob) {
   force_minimality();
 
   // solving
-  constraints.simplify(alphabet);
-  wout.debug_print("The horpo constraints are simplified to:\n" +
-    constraints.print() + "\n");
-
-  PFormula formula = constraints.generate_complete_formula();
-  formula = formula->simplify();
-
-  SatSolver sat;
-  if (!sat.solve(formula)) {
-    delete formula;
-    wout.abort_method("horpo");
-    return ret;
+  int size = 0;
+  vector<OrderRequirement*> reqs = problem->orientables();
+  for (int i = 0; i < reqs.size(); i++)
+    size += term_size(reqs[i]->left) + term_size(reqs[i]->right);
+
+  PFormula formula;
+  if (size > HORPO_LAZY_SIZE) {
+    if (!solve_lazily(formula)) {
+      delete formula;
+      wout.abort_method("horpo");
+      return ret;
+    }
+  }
+  else {
+    constraints.simplify(alphabet);
+    wout.debug_print("The horpo constraints are simplified to:\n" +
+      constraints.print() + "\n");
+
+    formula = constraints.generate_complete_formula();
+    formula = formula->simplify();
+
+    SatSolver sat;
+    if (!sat.solve(formula)) {
+      delete formula;
+      wout.abort_method("horpo");
+      return ret;
+    }
   }
   check_irrelevant_constraints(formula);
 
@@ -68,6 +83,36 @@ vector<int> Horpo :: orient(OrderingProblem *prob) {
   return ret;
 }
 
+bool Horpo :: solve_lazily(PFormula &formula) {
+  // constraints which have not been expanded yet are unrestricted,
+  // so if the formula is unsatisfiable, so is the full one; every
+  // round expands deeper, to keep the number of sat calls low
+  int depth = HORPO_LAZY_DEPTH;
+  for (int round = 1; ; round++, depth *= 2) {
+    if (round == HORPO_LAZY_ROUNDS) constraints.simplify(alphabet);
+    formula = constraints.generate_complete_formula();
+    formula = formula->simplify();
+    SatSolver sat;
+    if (!sat.solve(formula)) return false;
+    if (round == HORPO_LAZY_ROUNDS) break;
+    if (!constraints.expand_true(alphabet, depth)) break;
+    delete formula;
+    vars.reset_valuation();
+  }
+
+  wout.debug_print("The horpo constraints are simplified to:\n" +
+    constraints.print() + "\n");
+  constraints.exclude_unexpanded();
+  return true;
+}
+
+int Horpo :: term_size(PTerm term) {
+  int ret = 1;
+  for (int i = 0; i < term->number_children(); i++)
+    ret += term_size(term->get_child(i));
+  return ret;
+}
+
 bool Horpo :: has_monomorphic_applications(PTerm term) {
   if (term->query_application() && !term->query_head()->query_application()) {
     Varset TV = term->query_head()->query_type()->vars();
@@ -365,12 +410,86 @@ void Horpo :: save_argfun_constraints() {
 
 void Horpo :: save_precedence_constraints() {
   vector<string> symbols;
-  int i, j, k;
+  int i, j;
   for (map<string,int>::iterator it = alphabet.begin();
        it != alphabet.end(); it++) {
     symbols.push_back(it->first);
   }
 
+  if (symbols.size() > HORPO_PAIRWISE_PRECEDENCE)
+    save_precedence_levels(symbols);
+  else save_precedence_pairwise(symbols);
+
+  // the status function must respect the equality induced by the
+  // precedence
+  for (i = 0; i < symbols.size(); i++) {
+    string f = symbols[i];
+    for (j = 0; j < symbols.size(); j++) {
+      string g = symbols[j];
+      if (i == j) continue;
+      constraints.add_formula(new Or(
+          new AntiVar(precequal(f,g)),
+          new AntiVar(lex(f)),
+          new Var(lex(g))
+        ));
+      constraints.add_formula(new Or(
+          new AntiVar(precequal(f,g)),
+          new Var(lex(f)),
+          new AntiVar(lex(g))
+        ));
+    }
+  }
+
+  /** TODO:
+   * When implementing type changing functions, we must here put
+   * some additional constraints, that @_sigma = @_tau if sigma and
+   * tau define the same type.
+   * Probably use something like
+   * vector<Or*> different_types(sigma, tau)
+   * and add NOT PrecEq[@_sigma,@_tau] to all elements of that list
+   */
+
+  // only the dynamic dependency pair situation has further
+  // constraints
+  if (!problem->unfilterable_substeps_permitted()) return;
+
+  // in the monomorphic case, we must have that @_A >= @_B if B
+  // has at most equal length to A
+  // NOTE: when using type changing functions, we cannot just use
+  // "length" here, but must instead use a more advanced formula
+  if (monomorphic) {
+    for (i = 0; i < symbols.size(); i++) {
+      string f = symbols[i];
+      for (j = 0; j < symbols.size(); j++) {
+        string g = symbols[j];
+        if (f == g) continue;
+        if (f[0] == '@' && g[0] == '@') {
+          if (f.length() >= g.length())
+            constraints.add_formula(new Var(prec(f,g)));
+          else
+            constraints.add_formula(new AntiVar(prec(f,g)));
+        }
+      }
+    }
+  }
+
+  // in the non-monomorphic case, all @s are assigned the same
+  // symbol in the alphabet; however, we must still have that
+  // @_A > @_B if B is a strict subtype of A.  Mostly, the prec
+  // function will take care of that, but it means we cannot have
+  // f = @, since that would imply that both f = @_A and f = @_B
+  else if (alphabet.find("@") != alphabet.end()) {
+    for (i = 0; i < symbols.size(); i++) {
+      string f = symbols[i];
+      if (f == "@") continue;
+      constraints.add_formula(new AntiVar(precequal(f,"2")));
+    }
+  }
+}
+
+void Horpo :: save_precedence_pairwise(vector<string> &symbols) {
+  int i, j, k;
+
   // reflexivity
   for (i = 0; i < symbols.size(); i++) {
     constraints.add_formula(new Var(prec(symbols[i],symbols[i])));
@@ -453,72 +572,151 @@ void Horpo :: save_precedence_constraints() {
         ));
     }
   }
+}
 
-  // the status function must respect the equality induced by the
-  // precedence
+void Horpo :: save_precedence_levels(vector<string> &symbols) {
+  int i, j, k;
+
+  // every symbol gets a level of bits bits, the most significant last
+  int bits = 1;
+  while ((1 << bits) < symbols.size()) bits++;
+  map<string,int> level;
   for (i = 0; i < symbols.size(); i++) {
-    string f = symbols[i];
-    for (j = 0; j < symbols.size(); j++) {
-      string g = symbols[j];
-      if (i == j) continue;
-      constraints.add_formula(new Or(
-          new AntiVar(precequal(f,g)),
-          new AntiVar(lex(f)),
-          new Var(lex(g))
-        ));
-      constraints.add_formula(new Or(
-          new AntiVar(precequal(f,g)),
-          new Var(lex(f)),
-          new AntiVar(lex(g))
-        ));
+    level[symbols[i]] = vars.query_size();
+    vars.add_vars(bits);
+    for (k = 0; k < bits; k++) {
+      vars.set_description(level[symbols[i]] + k,
+        "Level[" + symbols[i] + "," + str(k) + "]");
     }
   }
 
-  /** TODO:
-   * When implementing type changing functions, we must here put
-   * some additional constraints, that @_sigma = @_tau if sigma and
-   * tau define the same type.
-   * Probably use something like
-   * vector<Or*> different_types(sigma, tau)
-   * and add NOT PrecEq[@_sigma,@_tau] to all elements of that list
-   */
+  // symbols which do not occur in the orientables can be given any
+  // place in the precedence, so we fix them to the lowest level
+  set<string> occurring = occurring_symbols();
+  for (i = 0; i < symbols.size(); i++) {
+    if (occurring.find(symbols[i]) != occurring.end()) continue;
+    for (k = 0; k < bits; k++)
+      constraints.add_formula(new AntiVar(level[symbols[i]] + k));
+  }
 
-  // only the dynamic dependency pair situation has further
-  // constraints
-  if (!problem->unfilterable_substeps_permitted()) return;
+  for (i = 0; i < symbols.size(); i++) {
+    string f = symbols[i];
+    constraints.add_formula(new Var(prec(f,f)));
+    constraints.add_formula(new AntiVar(precstrict(f,f)));
+    constraints.add_formula(new Var(precequal(f,f)));
+  }
 
-  // in the monomorphic case, we must have that @_A >= @_B if B
-  // has at most equal length to A
-  // NOTE: when using type changing functions, we cannot just use
-  // "length" here, but must instead use a more advanced formula
-  if (monomorphic) {
-    for (i = 0; i < symbols.size(); i++) {
-      string f = symbols[i];
-      for (j = 0; j < symbols.size(); j++) {
-        string g = symbols[j];
-        if (f == g) continue;
-        if (f[0] == '@' && g[0] == '@') {
-          if (f.length() >= g.length())
-            constraints.add_formula(new Var(prec(f,g)));
-          else
-            constraints.add_formula(new AntiVar(prec(f,g)));
+  for (i = 0; i < symbols.size(); i++) {
+    for (j = i+1; j < symbols.size(); j++) {
+      string f = symbols[i], g = symbols[j];
+      // eq+2k: the levels of f and g agree on bits 0..k
+      // eq+2k+1: on bits 0..k, the level of f is greater than g's
+      int eq = vars.query_size();
+      vars.add_vars(2 * bits);
+      for (k = 0; k < bits; k++) {
+        int fk = level[f] + k, gk = level[g] + k;
+        int e = eq + 2 * k, gr = e + 1;
+        if (k == 0) {
+          // e <-> (f_0 <-> g_0) and gr <-> f_0 /\ not g_0
+          constraints.add_formula(new Or(new AntiVar(e), new AntiVar(fk),
+                                         new Var(gk)));
+          constraints.add_formula(new Or(new AntiVar(e), new Var(fk),
+                                         new AntiVar(gk)));
+          constraints.add_formula(new Or(new Var(e), new Var(fk),
+                                         new Var(gk)));
+          constraints.add_formula(new Or(new Var(e), new AntiVar(fk),
+                                         new AntiVar(gk)));
+          constraints.add_formula(new Or(new AntiVar(gr), new Var(fk)));
+          constraints.add_formula(new Or(new AntiVar(gr),
+                                         new AntiVar(gk)));
+          constraints.add_formula(new Or(new Var(gr), new AntiVar(fk),
+                                         new Var(gk)));
+          continue;
         }
+        int preveq = e - 2, prevgr = gr - 2;
+        // e <-> e_{k-1} /\ (f_k <-> g_k)
+        constraints.add_formula(new Or(new AntiVar(e), new Var(preveq)));
+        constraints.add_formula(new Or(new AntiVar(e), new AntiVar(fk),
+                                       new Var(gk)));
+        constraints.add_formula(new Or(new AntiVar(e), new Var(fk),
+                                       new AntiVar(gk)));
+        Or *both = new Or(new Var(e), new AntiVar(preveq));
+        both->add_child(new Var(fk));
+        both->add_child(new Var(gk));
+        constraints.add_formula(both);
+        Or *neither = new Or(new Var(e), new AntiVar(preveq));
+        neither->add_child(new AntiVar(fk));
+        neither->add_child(new AntiVar(gk));
+        constraints.add_formula(neither);
+        // gr holds if at least two of f_k, not g_k and gr_{k-1} do
+        constraints.add_formula(new Or(new AntiVar(gr), new Var(fk),
+                                       new AntiVar(gk)));
+        constraints.add_formula(new Or(new AntiVar(gr), new Var(fk),
+                                       new Var(prevgr)));
+        constraints.add_formula(new Or(new AntiVar(gr), new AntiVar(gk),
+                                       new Var(prevgr)));
+        constraints.add_formula(new Or(new Var(gr), new AntiVar(fk),
+                                       new Var(gk)));
+        constraints.add_formula(new Or(new Var(gr), new AntiVar(fk),
+                                       new AntiVar(prevgr)));
+        constraints.add_formula(new Or(new Var(gr), new Var(gk),
+                                       new AntiVar(prevgr)));
       }
+
+      // the precedence variables are the comparisons on all bits; g
+      // is greater than f if they are neither equal nor f greater
+      int e = eq + 2 * (bits-1), gr = e + 1;
+      link_precedence(f, g, e, gr);
+      int lt = vars.query_size();
+      vars.add_vars(1);
+      constraints.add_formula(new Or(new AntiVar(lt), new AntiVar(e)));
+      constraints.add_formula(new Or(new AntiVar(lt), new AntiVar(gr)));
+      constraints.add_formula(new Or(new Var(lt), new Var(e),
+                                     new Var(gr)));
+      link_precedence(g, f, e, lt);
     }
   }
+}
 
-  // in the non-monomorphic case, all @s are assigned the same
-  // symbol in the alphabet; however, we must still have that
-  // @_A > @_B if B is a strict subtype of A.  Mostly, the prec
-  // function will take care of that, but it means we cannot have
-  // f = @, since that would imply that both f = @_A and f = @_B
-  else if (alphabet.find("@") != alphabet.end()) {
-    for (i = 0; i < symbols.size(); i++) {
-      string f = symbols[i];
-      if (f == "@") continue;
-      constraints.add_formula(new AntiVar(precequal(f,"2")));
+void Horpo :: link_precedence(string f, string g, int eq, int gr) {
+  constraints.add_formula(new Or(new AntiVar(precequal(f,g)),
+                                 new Var(eq)));
+  constraints.add_formula(new Or(new Var(precequal(f,g)),
+                                 new AntiVar(eq)));
+  constraints.add_formula(new Or(new AntiVar(precstrict(f,g)),
+                                 new Var(gr)));
+  constraints.add_formula(new Or(new Var(precstrict(f,g)),
+                                 new AntiVar(gr)));
+  constraints.add_formula(new Or(new AntiVar(prec(f,g)),
+                                 new Var(eq), new Var(gr)));
+  constraints.add_formula(new Or(new Var(prec(f,g)), new AntiVar(eq)));
+  constraints.add_formula(new Or(new Var(prec(f,g)), new AntiVar(gr)));
+}
+
+set<string> Horpo :: occurring_symbols() {
+  vector<OrderRequirement*> reqs = problem->orientables();
+  set<string> ret;
+
+  for (int i = 0; i < reqs.size(); i++) {
+    vector<PTerm> subs;
+    subs.push_back(reqs[i]->left);
+    subs.push_back(reqs[i]->right);
+    for (int j = 0; j < subs.size(); j++) {
+      PTerm term = subs[j];
+      for (int k = 0; k < term->number_children(); k++)
+        subs.push_back(term->get_child(k));
+      if (term->query_constant())
+        ret.insert(dynamic_cast<PConstant>(term)->query_name());
     }
   }
+
+  // application symbols are introduced when making the orientables
+  // application-free
+  for (map<string,int>::iterator it = alphabet.begin();
+       it != alphabet.end(); it++) {
+    if (it->first[0] == '@') ret.insert(it->first);
+  }
+  return ret;
 }
 
 void Horpo :: force_minimality() {
@@ -747,16 +945,16 @@ void Horpo :: get_constraint(int variable, PTerm &left, PTerm &right,
   else {
     left = constraint->left;
     right = constraint->right;
-    if (constraint->relation == ">")  relation = ">";
+    if (constraint->relation == HORPO_GREATER)  relation = ">";
     else {
       relation = ">=";
-      if (constraint->relation == ">=fun") rule = "(Fun)";
-      if (constraint->relation == ">=eta")
+      if (constraint->relation == HORPO_FUN) rule = "(Fun)";
+      if (constraint->relation == HORPO_ETA)
         rule = "(Eta)" + wout.cite("Kop13:2");
-      if (constraint->relation == ">=stat") rule = "(Stat)";
-      if (constraint->relation == ">=fabs") rule = "(F-Abs)";
-      if (constraint->relation == ">=copy") rule = "(Copy)";
-      if (constraint->relation == ">=select") rule = "(Select)";
+      if (constraint->relation == HORPO_STAT) rule = "(Stat)";
+      if (constraint->relation == HORPO_FABS) rule = "(F-Abs)";
+      if (constraint->relation == HORPO_COPY) rule = "(Copy)";
+      if (constraint->relation == HORPO_SELECT) rule = "(Select)";
     }
   }
 }
@@ -23,6 +23,20 @@
 #include "requirement.h"
 #include "orderingproblem.h"
 
+#define HORPO_PAIRWISE_PRECEDENCE 24
+  // for alphabets of at most this size, the precedence is encoded by
+  // transitivity constraints on pairwise comparisons; for larger
+  // ones, every symbol is assigned a level in binary
+#define HORPO_LAZY_SIZE 800
+  // if the orientables have more symbols than this in total, the
+  // constraints are expanded only on demand
+#define HORPO_LAZY_DEPTH 2
+  // the number of levels expanded below a constraint which is true in
+  // a candidate solution; this doubles in every round
+#define HORPO_LAZY_ROUNDS 6
+  // the maximum number of sat calls before the remaining constraints
+  // are all expanded at once
+
 class Horpo {
   private:
     OrderingProblem *problem;
@@ -64,6 +78,19 @@ class Horpo {
     void save_precedence_constraints();
       // saves constraints for the precedence (this includes the
       // requirement that the status respects the precedence)
+    void save_precedence_pairwise(vector<string> &symbols);
+      // makes the precedence variables a total quasi-ordering using
+      // reflexivity, transitivity and totality constraints; this is
+      // cubic in the size of the alphabet
+    void save_precedence_levels(vector<string> &symbols);
+      // makes the precedence variables a total quasi-ordering by
+      // comparing binary levels for all symbols; this is quadratic
+      // in the size of the alphabet, times the number of bits
+    void link_precedence(string f, string g, int eq, int gr);
+      // makes the precedence variables for f and g equivalent to the
+      // given variables for f = g and f > g
+    set<string> occurring_symbols();
+      // returns the symbols which occur in the orientables
     void force_minimality();
       // sets the formulas so symbols of arity 0 which only occur in
       // the left-hand sides of the constraints are mapped to minimal
@@ -72,6 +99,15 @@ class Horpo {
       // returns whether all type variables occurring in b also
       // occur in a, and at least as often; if exactly is true, then
       // they must occur exactly as often in a as in b
+    int term_size(PTerm term);
+      // returns the number of symbols, variables and abstractions in
+      // the given term
+    bool solve_lazily(PFormula &formula);
+      // solves the constraints while only expanding those which are
+      // true in a candidate solution; constraints which are left
+      // unexpanded are assumed false, so the resulting valuation is
+      // a solution of the full constraint list, and formula contains
+      // all expanded constraints
     void check_irrelevant_constraints(PFormula formula);
       // the sat solver has a tendency to make variables false if they
       // are not necessary for the formula to hold; consequently, only
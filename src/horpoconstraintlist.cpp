@@ -19,26 +19,37 @@
 #include <cstdio>
 #include <iostream>
 
-string HorpoConstraintList :: print_horpo_constraint(PTerm left, PTerm right,
-              string relation, PTerm restriction_term, int restriction_num) {
-  string ret = left->to_string(environment, true) + " " + relation + " " +
-               right->to_string(environment, true);
-  if (restriction_term != NULL) {
-    char num[] = " ";
-    num[0] = '0' + restriction_num;
-    ret += " RST (" + restriction_term->to_string(environment, true) + "," +
-                 string(num) + ")";
+string HorpoConstraintList :: relation_string(HorpoRelation relation) {
+  switch (relation) {
+    case HORPO_GREATER: return ">";
+    case HORPO_GEQ: return ">=";
+    case HORPO_STDR: return ">=stdr";
+    case HORPO_FUN: return ">=fun";
+    case HORPO_ETA: return ">=eta";
+    case HORPO_STAT: return ">=stat";
+    case HORPO_FABS: return ">=fabs";
+    case HORPO_COPY: return ">=copy";
+    case HORPO_SELECT: return ">=select";
+    case HORPO_RST: return ">=RST";
   }
-  return ret;
+  return "";
 }
 
 string HorpoConstraintList :: print_horpo_constraint(HorpoConstraint *hc) {
-  return print_horpo_constraint(hc->left, hc->right, hc->relation,
-                                hc->restriction_term, hc->restriction_num);
+  string ret = hc->left->to_string(environment, true) + " " +
+               relation_string(hc->relation) + " " +
+               hc->right->to_string(environment, true);
+  if (hc->restriction_term != NULL) {
+    char num[] = " ";
+    num[0] = '0' + hc->restriction_num;
+    ret += " RST (" + hc->restriction_term->to_string(environment, true) +
+           "," + string(num) + ")";
+  }
+  return ret;
 }
 
 HorpoConstraint :: HorpoConstraint(PTerm _left, PTerm _right,
-                     string _relation, PTerm _resterm, int _resnum,
+                     HorpoRelation _relation, PTerm _resterm, int _resnum,
                      int _varindex) {
   left = _left;
   right = _right;
@@ -46,6 +57,8 @@ HorpoConstraint :: HorpoConstraint(PTerm _left, PTerm _right,
   restriction_term = _resterm;
   restriction_num = _resnum;
   variable_index = _varindex;
+  justification_start = -1;
+  justification_end = -1;
 }
 
 HorpoConstraint :: ~HorpoConstraint() {
@@ -56,43 +69,164 @@ HorpoConstraint :: ~HorpoConstraint() {
 
 HorpoConstraintList :: HorpoConstraintList(Horpo *_master) {
   master = _master;
-  handled = 0;
+  number_terms = 0;
 }
 
 void HorpoConstraintList :: reset() {
   int i;
 
-  handled = 0;
   for (i = 0; i < formulas.size(); i++) delete formulas[i];
   formulas.clear();
   for (i = 0; i < constraints.size(); i++) delete constraints[i];
   constraints.clear();
+  for (i = 0; i < term_table.size(); i++) delete term_table[i];
+  term_table.clear();
+  constraint_table.clear();
+  number_terms = 0;
+}
+
+/* ========== LOOKING UP TERMS AND CONSTRAINTS ========== */
+
+unsigned int HorpoConstraintList :: term_hash(PTerm term,
+                                              set<long> &bound) {
+  // alpha-equal terms must have the same hash, so all variables bound
+  // inside the term are treated alike
+  unsigned int ret;
+  if (term->query_constant()) {
+    string name = dynamic_cast<PConstant>(term)->query_name();
+    ret = 1;
+    for (int i = 0; i < name.length(); i++) ret = ret * 31 + name[i];
+    return ret;
+  }
+  if (term->query_variable()) {
+    long id = dynamic_cast<PVariable>(term)->query_index();
+    if (bound.find(id) != bound.end()) return 2;
+    return 3 + 7 * id;
+  }
+  if (term->query_abstraction()) {
+    long id = dynamic_cast<Abstraction*>(term)->
+                query_abstraction_variable()->query_index();
+    bool added = bound.insert(id).second;
+    ret = 5 * 1000003 ^ term_hash(term->get_child(0), bound);
+    if (added) bound.erase(id);
+    return ret;
+  }
+  if (term->query_meta())
+    ret = 11 + 13 * dynamic_cast<MetaApplication*>(term)->
+                      get_metavar()->query_index();
+  else ret = 17;
+  for (int i = 0; i < term->number_children(); i++)
+    ret = ret * 1000003 ^ term_hash(term->get_child(i), bound);
+  return ret;
+}
+
+int HorpoConstraintList :: find_term(PTerm term, unsigned int hash) {
+  if (term_table.empty()) return -1;
+  int mask = term_table.size() - 1;
+  for (int pos = hash & mask; term_table[pos] != NULL;
+       pos = (pos + 1) & mask) {
+    if (term_table[pos]->hash == hash &&
+        term_table[pos]->term->equals(term)) return term_table[pos]->id;
+  }
+  return -1;
+}
+
+int HorpoConstraintList :: term_id(PTerm term) {
+  set<long> bound;
+  unsigned int hash = term_hash(term, bound);
+  int id = find_term(term, hash);
+  if (id != -1) return id;
+
+  // the given term is stored, so it must be owned by a constraint
+  if (2 * (number_terms + 1) > term_table.size()) {
+    vector<TermEntry*> old = term_table;
+    term_table.clear();
+    term_table.resize(old.empty() ? 64 : 2 * old.size(), NULL);
+    for (int i = 0; i < old.size(); i++) {
+      if (old[i] != NULL) insert_term(old[i]);
+    }
+  }
+  TermEntry *entry = new TermEntry;
+  entry->term = term;
+  entry->hash = hash;
+  entry->id = number_terms++;
+  insert_term(entry);
+  return entry->id;
+}
+
+void HorpoConstraintList :: insert_term(TermEntry *entry) {
+  int mask = term_table.size() - 1;
+  int pos = entry->hash & mask;
+  while (term_table[pos] != NULL) pos = (pos + 1) & mask;
+  term_table[pos] = entry;
+}
+
+unsigned int HorpoConstraintList :: constraint_hash(int left, int right,
+                  HorpoRelation relation, int restriction, int resnum) {
+  unsigned int ret = left;
+  ret = ret * 1000003 ^ right;
+  ret = ret * 1000003 ^ relation;
+  ret = ret * 1000003 ^ restriction;
+  ret = ret * 1000003 ^ resnum;
+  return ret;
+}
+
+int HorpoConstraintList :: find_constraint(int left, int right,
+                  HorpoRelation relation, int restriction, int resnum) {
+  if (constraint_table.empty()) return -1;
+  int mask = constraint_table.size() - 1;
+  int pos = constraint_hash(left, right, relation, restriction, resnum)
+            & mask;
+  for (; constraint_table[pos] != -1; pos = (pos + 1) & mask) {
+    HorpoConstraint *c = constraints[constraint_table[pos]];
+    if (c->left_id == left && c->right_id == right &&
+        c->relation == relation && c->restriction_id == restriction &&
+        c->restriction_num == resnum) return constraint_table[pos];
+  }
+  return -1;
+}
+
+void HorpoConstraintList :: insert_constraint(int index) {
+  HorpoConstraint *c = constraints[index];
+  int mask = constraint_table.size() - 1;
+  int pos = constraint_hash(c->left_id, c->right_id, c->relation,
+                            c->restriction_id, c->restriction_num) & mask;
+  while (constraint_table[pos] != -1) pos = (pos + 1) & mask;
+  constraint_table[pos] = index;
 }
 
+/* ========== ADDING CONSTRAINTS ========== */
+
 int HorpoConstraintList :: add_constraint(PTerm left, PTerm right,
-                    string relation, PTerm restriction, int limit) {
+                    HorpoRelation relation, PTerm restriction, int limit) {
   int num = vars.query_size();
   HorpoConstraint *constraint = new HorpoConstraint(left, right,
                                   relation, restriction, limit, num);
-  string printed = print_horpo_constraint(constraint);
+  constraint->left_id = term_id(left);
+  constraint->right_id = term_id(right);
+  constraint->restriction_id =
+    restriction == NULL ? -1 : term_id(restriction);
   vars.add_vars(1);
-  char strid[10];
-  sprintf(strid, "%d", constraints.size());
-  vars.set_description(num, "constraint " + string(strid));
-  //vars.set_description(num, "[[" + printed + "]]");
+  vars.set_description(num, "constraint");
 
-  constraint_lookup[printed] = constraints.size();
   constraints.push_back(constraint);
+  if (2 * constraints.size() > constraint_table.size()) {
+    int size = constraint_table.empty() ? 64 : 2 * constraint_table.size();
+    constraint_table.clear();
+    constraint_table.resize(size, -1);
+    for (int i = 0; i < constraints.size(); i++) insert_constraint(i);
+  }
+  else insert_constraint(constraints.size()-1);
 
   return num;
 }
 
 int HorpoConstraintList :: add_geq(PTerm left, PTerm right) {
-  return add_constraint(left, right, ">=", NULL, 0);
+  return add_constraint(left, right, HORPO_GEQ, NULL, 0);
 }
 
 int HorpoConstraintList :: add_greater(PTerm left, PTerm right) {
-  return add_constraint(left, right, ">", NULL, 0);
+  return add_constraint(left, right, HORPO_GREATER, NULL, 0);
 }
 
 void HorpoConstraintList :: add_formula(PFormula formula) {
@@ -100,33 +234,38 @@ void HorpoConstraintList :: add_formula(PFormula formula) {
 }
 
 int HorpoConstraintList :: index_of_constraint(PTerm left, PTerm right,
-        string relation, PTerm restriction_term, int restriction_num) {
-
-  string tmp = print_horpo_constraint(left, right, relation,
-                                      restriction_term, restriction_num);
-  if (constraint_lookup.find(tmp) == constraint_lookup.end()) {
-    // the constraint doesn't exist yet - add it!
-    add_constraint(left->copy(), right->copy(), relation,
-                   restriction_term == NULL ? NULL : restriction_term->copy(),
-                   restriction_num);
-    return constraints.size()-1;
-  }
-  else return constraint_lookup[tmp];
+        HorpoRelation relation, PTerm restriction_term,
+        int restriction_num) {
+  // if one of the terms is not known yet, neither is the constraint
+  set<long> bound;
+  int lid = find_term(left, term_hash(left, bound));
+  int rid = find_term(right, term_hash(right, bound));
+  int sid = -1;
+  if (restriction_term != NULL)
+    sid = find_term(restriction_term, term_hash(restriction_term, bound));
+  if (lid != -1 && rid != -1 && (restriction_term == NULL || sid != -1)) {
+    int index = find_constraint(lid, rid, relation, sid, restriction_num);
+    if (index != -1) return index;
+  }
+
+  // the constraint doesn't exist yet - add it!
+  add_constraint(left->copy(), right->copy(), relation,
+                 restriction_term == NULL ? NULL : restriction_term->copy(),
+                 restriction_num);
+  return constraints.size()-1;
 }
 
 int HorpoConstraintList :: var_for_constraint(PTerm left, PTerm right,
-                         string relation, PTerm resterm, int resnum) {
+                         HorpoRelation relation, PTerm resterm, int resnum) {
   
   int constraint_index = index_of_constraint(left, right, relation,
                                              resterm, resnum);
   return constraints[constraint_index]->variable_index;
 }
 
-int HorpoConstraintList :: query_constraint_variable(PTerm left, PTerm
-                                             right, string relation) {
-  int index = constraint_lookup[print_horpo_constraint(left, right,
-                                                relation, NULL, 0)];
-  return constraints[index]->variable_index;
+int HorpoConstraintList :: query_constraint_variable(PTerm left,
+                             PTerm right, HorpoRelation relation) {
+  return var_for_constraint(left, right, relation);
 }
 
 And *HorpoConstraintList :: generate_complete_formula() {
@@ -275,7 +414,7 @@ void HorpoConstraintList :: handle_greater(PTerm left,
   string fname = f->query_name();
   
   f->rename(fname + "*");
-  int newid = var_for_constraint(left, right, ">=");
+  int newid = var_for_constraint(left, right, HORPO_GEQ);
   f->rename(fname);
 
   // either f is filtered away, of we should mark it
@@ -302,11 +441,11 @@ void HorpoConstraintList :: handle_greater(PTerm left,
   for (int i = 1; i < split.size(); i++) {
     PTerm li = split[i];
     if (leftsub == left) {
-      newid = var_for_constraint(li, right, ">");
+      newid = var_for_constraint(li, right, HORPO_GREATER);
     }
     else {
       PTerm tmp = left->replace_subterm(li, subpos);
-      newid = var_for_constraint(left, right, ">");
+      newid = var_for_constraint(left, right, HORPO_GREATER);
       left->replace_subterm(tmp, subpos);
     }
     add_formula(bigOr(
@@ -326,7 +465,7 @@ void HorpoConstraintList :: handle_basic_geq(PTerm left,
   if (!split[0]->query_constant()) {
     add_formula(new Or(
         new AntiVar(index),
-        new Var(var_for_constraint(left, right, ">=stdr"))
+        new Var(var_for_constraint(left, right, HORPO_STDR))
       ));
     return;
   }
@@ -340,7 +479,7 @@ void HorpoConstraintList :: handle_basic_geq(PTerm left,
       new AntiVar(index),
       new Var(master->symbol_filtered(gname)),
       new Var(master->minimal(gname)),
-      new Var(var_for_constraint(left, right, ">=stdr"))
+      new Var(var_for_constraint(left, right, HORPO_STDR))
     ));
 
   // if g is filtered away, then left should still be >= its child
@@ -349,7 +488,7 @@ void HorpoConstraintList :: handle_basic_geq(PTerm left,
         new AntiVar(index),
         new AntiVar(master->symbol_filtered(gname)),
         new Var(master->arg_filtered(gname, i)),
-        new Var(var_for_constraint(left, split[i], ">="))
+        new Var(var_for_constraint(left, split[i], HORPO_GEQ))
       ));
   }
 }
@@ -379,7 +518,7 @@ void HorpoConstraintList :: handle_standard_right(PTerm left,
         add_formula(new Or(
             new AntiVar(index),
             new Var(var_for_constraint(left->get_child(i),
-                                       right->get_child(i), ">="))
+                                       right->get_child(i), HORPO_GEQ))
           ));
       }
       return;
@@ -404,7 +543,7 @@ void HorpoConstraintList :: handle_standard_right(PTerm left,
 
     add_formula(new Or(
         new AntiVar(index),
-        new Var(var_for_constraint(subl, subr, ">="))
+        new Var(var_for_constraint(subl, subr, HORPO_GEQ))
       ));
 
     delta.remove(varr);
@@ -417,7 +556,7 @@ void HorpoConstraintList :: handle_standard_right(PTerm left,
   if (left->query_abstraction()) {
     add_formula(new Or(
         new AntiVar(index),
-        new Var(var_for_constraint(left, right, ">=eta"))
+        new Var(var_for_constraint(left, right, HORPO_ETA))
       ));
     return;
   }
@@ -435,10 +574,10 @@ void HorpoConstraintList :: handle_standard_right(PTerm left,
   if (fname[fname.length()-1] == '*') {
     add_formula(bigOr(
         new AntiVar(index),
-        new Var(var_for_constraint(left, right, ">=select", resterm, resnum)),
-        new Var(var_for_constraint(left, right, ">=fabs")),
-        new Var(var_for_constraint(left, right, ">=copy")),
-        new Var(var_for_constraint(left, right, ">=stat"))
+        new Var(var_for_constraint(left, right, HORPO_SELECT, resterm, resnum)),
+        new Var(var_for_constraint(left, right, HORPO_FABS)),
+        new Var(var_for_constraint(left, right, HORPO_COPY)),
+        new Var(var_for_constraint(left, right, HORPO_STAT))
       ));
   }
 
@@ -457,10 +596,10 @@ void HorpoConstraintList :: handle_standard_right(PTerm left,
     for (int i = 1; i < lparts.size(); i++) {
       int newconstraint;
       if (resterm == NULL) {
-        newconstraint = var_for_constraint(lparts[i], right, ">=stdr");
+        newconstraint = var_for_constraint(lparts[i], right, HORPO_STDR);
       }
       else {
-        newconstraint = var_for_constraint(lparts[i], right, ">=RST",
+        newconstraint = var_for_constraint(lparts[i], right, HORPO_RST,
           resterm, resnum);
       }
 
@@ -476,17 +615,17 @@ void HorpoConstraintList :: handle_standard_right(PTerm left,
     f->rename(fname + "*");
     int markedconstraint;
     if (resterm == NULL) {
-      markedconstraint = var_for_constraint(left, right, ">=stdr");
+      markedconstraint = var_for_constraint(left, right, HORPO_STDR);
     }
     else {
-      markedconstraint = var_for_constraint(left, right, ">=RST",
+      markedconstraint = var_for_constraint(left, right, HORPO_RST,
                                             resterm, resnum);
     }
     f->rename(fname);
     add_formula(bigOr(
         new AntiVar(index),
         new Var(master->symbol_filtered(fname)),
-        new Var(var_for_constraint(left, right, ">=fun")),
+        new Var(var_for_constraint(left, right, HORPO_FUN)),
         new Var(markedconstraint)
       ));
   }
@@ -551,7 +690,7 @@ void HorpoConstraintList :: handle_fun(PTerm left,
             new AntiVar(master->lex(fname)),
             new AntiVar(master->permutation(fname, i, j)),
             new AntiVar(master->permutation(gname, k, j)),
-            new Var(var_for_constraint(lsplit[i], rsplit[k], ">="))
+            new Var(var_for_constraint(lsplit[i], rsplit[k], HORPO_GEQ))
           ));
       }
     }
@@ -628,7 +767,7 @@ void HorpoConstraintList :: handle_fun(PTerm left,
           new AntiVar(index),
           new Var(master->lex(fname)),
           new AntiVar(Aij),
-          new Var(var_for_constraint(lsplit[i], rsplit[j], ">="))
+          new Var(var_for_constraint(lsplit[i], rsplit[j], HORPO_GEQ))
         ));
     }
   }
@@ -662,7 +801,7 @@ void HorpoConstraintList :: handle_eta(PTerm left,
     int filtered = master->arg_filtered(fname, i);
     PTerm si = subparts[i];
     l->replace_child(0, si);
-    int newc = var_for_constraint(l, right, ">=eta");
+    int newc = var_for_constraint(l, right, HORPO_ETA);
     l->replace_child(0, lsub);
     Or *newform = new Or(
         new AntiVar(index),
@@ -715,7 +854,7 @@ void HorpoConstraintList :: handle_eta(PTerm left,
     }
     add_formula(new Or(
         new AntiVar(newindex),
-        new Var(var_for_constraint(subparts[i], right, ">=stdr"))
+        new Var(var_for_constraint(subparts[i], right, HORPO_STDR))
       ));
   }
   add_formula(atleastone);
@@ -776,14 +915,14 @@ void HorpoConstraintList :: handle_lex(PTerm left, PTerm right,
             new AntiVar(Pstart+i+1),
             new AntiVar(master->permutation(fname, a, i)),
             new AntiVar(master->permutation(gname, b, i)),
-            new Var(var_for_constraint(lsplit[a], rsplit[b], ">="))
+            new Var(var_for_constraint(lsplit[a], rsplit[b], HORPO_GEQ))
           ));
         add_formula(bigOr(  // if p = i, then li > ri, if ri exists
             new AntiVar(Pstart+i),
             new Var(Pstart+i+1),
             new AntiVar(master->permutation(fname, a, i)),
             new AntiVar(master->permutation(gname, b, i)),
-            new Var(var_for_constraint(lsplit[a], rsplit[b], ">"))
+            new Var(var_for_constraint(lsplit[a], rsplit[b], HORPO_GREATER))
           ));
       }
     }
@@ -796,7 +935,7 @@ void HorpoConstraintList :: handle_lex(PTerm left, PTerm right,
         new AntiVar(index),
         new AntiVar(master->lex(fname)),
         new Var(master->arg_filtered(gname, i)),
-        new Var(var_for_constraint(lretyped, rsplit[i], ">="))
+        new Var(var_for_constraint(lretyped, rsplit[i], HORPO_GEQ))
       ));
     destroy_retyped(lretyped);
   }
@@ -880,12 +1019,12 @@ void HorpoConstraintList :: handle_mul(PTerm left, PTerm right,
       add_formula(new Or(
           new AntiVar(Z+i*m+j),
           new AntiVar(C+i),
-          new Var(var_for_constraint(lsplit[i], rsplit[j], ">"))
+          new Var(var_for_constraint(lsplit[i], rsplit[j], HORPO_GREATER))
         ));
       add_formula(new Or(
           new AntiVar(Z+i*m+j),
           new Var(C+i),
-          new Var(var_for_constraint(lsplit[i], rsplit[j], ">="))
+          new Var(var_for_constraint(lsplit[i], rsplit[j], HORPO_GEQ))
         ));
     }
   }
@@ -966,7 +1105,7 @@ void HorpoConstraintList :: handle_fabs(PTerm left,
   PTerm new_l = new Application(left, X);
   add_formula(new Or(
       new AntiVar(index),
-      new Var(var_for_constraint(new_l, r, ">="))
+      new Var(var_for_constraint(new_l, r, HORPO_GEQ))
     ));
   new_l->replace_child(0, NULL);
   delete new_l;
@@ -1005,7 +1144,7 @@ void HorpoConstraintList :: handle_copy(PTerm left,
     add_formula(new Or(
         new AntiVar(index),
         new Var(master->arg_filtered(gname, i)),
-        new Var(var_for_constraint(lretyped, rsplit[i], ">="))
+        new Var(var_for_constraint(lretyped, rsplit[i], HORPO_GEQ))
       ));
     destroy_retyped(lretyped);
   }
@@ -1055,11 +1194,11 @@ void HorpoConstraintList :: handle_select(PTerm left,
     formula = new Or(new AntiVar(K+i));
     if (resterm == left) {
       formula->add_child(new Var(
-        var_for_constraint(lsplit[i], right, ">=stdr")));
+        var_for_constraint(lsplit[i], right, HORPO_STDR)));
     }
     else {
       formula->add_child(new Var(
-        var_for_constraint(lsplit[i], right, ">=RST",
+        var_for_constraint(lsplit[i], right, HORPO_RST,
                            resterm, resnum)));
     }
 
@@ -1105,7 +1244,7 @@ void HorpoConstraintList :: handle_select(PTerm left,
         k++;
       }
       formula->add_child(new Var(var_for_constraint(term, right,
-        ">=RST", resterm, resnum-1)));
+        HORPO_RST, resterm, resnum-1)));
       type = term->query_type();
     }
 
@@ -1147,7 +1286,7 @@ void HorpoConstraintList :: handle_restricted(PTerm left,
   if (measure(left) < measure(resterm)) {
     add_formula(new Or(
         new AntiVar(index),
-        new Var(var_for_constraint(left, right, ">=stdr"))
+        new Var(var_for_constraint(left, right, HORPO_STDR))
       ));
     return;
   }
@@ -1163,54 +1302,105 @@ void HorpoConstraintList :: handle_restricted(PTerm left,
 }
 
 void HorpoConstraintList :: simplify(map<string,int> &arities) {
-  // any constraint with index < handled is DONE
-  // any constraint with index >= handled is TODO
-  for (; handled < constraints.size(); handled++) {
-    PTerm left = constraints[handled]->left;
-    PTerm right = constraints[handled]->right;
-    string relation = constraints[handled]->relation;
-    int index = constraints[handled]->variable_index;
-
-    constraints[handled]->justification_start = formulas.size();
-
-    // only terms of equal type (modulo collapsing of base types)
-    // can be compared (in the future, we will here add type
-    // changing functions
-    vector<Or*> type_equality = master->force_type_equality(
-                    left->query_type(), right->query_type());
-    bool pointless = false;
-    for (int i = 0; i < type_equality.size(); i++) {
-      if (type_equality[i]->query_number_children() == 0) pointless = true;
-      type_equality[i]->add_child(new AntiVar(index));
-      add_formula(type_equality[i]);
+  // expanding a constraint may add new ones at the end of the list,
+  // which are then handled by the same loop
+  for (int i = 0; i < constraints.size(); i++) {
+    if (constraints[i]->justification_start == -1) expand(i, arities);
+  }
+}
+
+bool HorpoConstraintList :: expand_true(map<string,int> &arities,
+                                        int depth) {
+  vector<int> todo;
+  int i;
+  for (i = 0; i < constraints.size(); i++) {
+    if (constraints[i]->justification_start == -1 &&
+        vars.query_value(constraints[i]->variable_index) == TRUE)
+      todo.push_back(i);
+  }
+  if (todo.empty()) return false;
+
+  // the constraints created by an expansion have no value yet; we
+  // expand them too, up to the given depth
+  int start = constraints.size();
+  for (i = 0; i < todo.size(); i++) expand(todo[i], arities);
+  for (int level = 1; level < depth; level++) {
+    int end = constraints.size();
+    for (i = start; i < end; i++) {
+      if (constraints[i]->justification_start == -1) expand(i, arities);
     }
-    if (pointless) continue;
+    start = end;
+  }
+  return true;
+}
 
-    // consider the various forms a constraint might have
-    if (relation == ">")
+void HorpoConstraintList :: exclude_unexpanded() {
+  for (int i = 0; i < constraints.size(); i++) {
+    if (constraints[i]->justification_start == -1)
+      vars.force_value(constraints[i]->variable_index, FALSE);
+  }
+}
+
+void HorpoConstraintList :: expand(int i, map<string,int> &arities) {
+  constraints[i]->justification_start = formulas.size();
+  handle_constraint(constraints[i], arities);
+  constraints[i]->justification_end = formulas.size();
+}
+
+void HorpoConstraintList :: handle_constraint(HorpoConstraint *constraint,
+                                              map<string,int> &arities) {
+  PTerm left = constraint->left;
+  PTerm right = constraint->right;
+  HorpoRelation relation = constraint->relation;
+  int index = constraint->variable_index;
+
+  // only terms of equal type (modulo collapsing of base types)
+  // can be compared (in the future, we will here add type
+  // changing functions
+  vector<Or*> type_equality = master->force_type_equality(
+                  left->query_type(), right->query_type());
+  bool pointless = false;
+  for (int i = 0; i < type_equality.size(); i++) {
+    if (type_equality[i]->query_number_children() == 0) pointless = true;
+    type_equality[i]->add_child(new AntiVar(index));
+    add_formula(type_equality[i]);
+  }
+  if (pointless) return;
+
+  // consider the various forms a constraint might have
+  switch (relation) {
+    case HORPO_GREATER:
       handle_greater(left, right, index);
-    else if (relation == ">=")
+      break;
+    case HORPO_GEQ:
       handle_basic_geq(left, right, index);
-    else if (relation == ">=stdr")
+      break;
+    case HORPO_STDR:
       handle_standard_right(left, right, index, NULL, 0);
-    else if (relation == ">=fun")
+      break;
+    case HORPO_FUN:
       handle_fun(left, right, index);
-    else if (relation == ">=eta")
+      break;
+    case HORPO_ETA:
       handle_eta(left, right, index, arities);
-    else if (relation == ">=stat")
+      break;
+    case HORPO_STAT:
       handle_stat(left, right, index, arities);
-    else if (relation == ">=fabs")
+      break;
+    case HORPO_FABS:
       handle_fabs(left, right, index);
-    else if (relation == ">=copy")
+      break;
+    case HORPO_COPY:
       handle_copy(left, right, index);
-    else if (relation == ">=select")
-      handle_select(left, right, index,
-                    constraints[handled]->restriction_term,
-                    constraints[handled]->restriction_num);
-    else if (relation == ">=RST")
-      handle_restricted(left, right, index,
-                        constraints[handled]->restriction_term,
-                        constraints[handled]->restriction_num);
+      break;
+    case HORPO_SELECT:
+      handle_select(left, right, index, constraint->restriction_term,
+                    constraint->restriction_num);
+      break;
+    case HORPO_RST:
+      handle_restricted(left, right, index, constraint->restriction_term,
+                        constraint->restriction_num);
+      break;
   }
 }
 
@@ -1219,9 +1409,7 @@ vector<PFormula> HorpoConstraintList :: justify_constraint(int index) {
   for (int i = 0; i < constraints.size(); i++) {
     if (constraints[i]->variable_index == index) {
       int start = constraints[i]->justification_start;
-      int end = formulas.size();
-      if (i+1 < constraints.size())
-        end = constraints[i+1]->justification_start;
+      int end = constraints[i]->justification_end;
       for (int j = start; j < end; j++) {
         ret.push_back(formulas[j]);
       }
@@ -1234,7 +1422,8 @@ vector<PFormula> HorpoConstraintList :: justify_constraint(int index) {
 vector<int> HorpoConstraintList :: constraint_variables() {
   vector<int> ret;
   for (int i = 0; i < constraints.size(); i++) {
-    ret.push_back(constraints[i]->variable_index);
+    if (constraints[i]->justification_start != -1)
+      ret.push_back(constraints[i]->variable_index);
   }
   return ret;
 }
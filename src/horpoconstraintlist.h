@@ -22,49 +22,97 @@
 
 class Horpo;
 
+enum HorpoRelation { HORPO_GREATER, HORPO_GEQ, HORPO_STDR, HORPO_FUN,
+                     HORPO_ETA, HORPO_STAT, HORPO_FABS, HORPO_COPY,
+                     HORPO_SELECT, HORPO_RST };
+  // >, >= and the forms >=A of >= which are restricted to rule A
+
 struct HorpoConstraint {
   PTerm left;
   PTerm right;
-  string relation;  // >, >=, >=A, where A in {Fun,Mul,...,stdr,RST}
+  HorpoRelation relation;
   PTerm restriction_term;
   int restriction_num;
+  int left_id, right_id, restriction_id;
+    // the identifiers of the terms in the term table; restriction_id
+    // is -1 if there is no restriction term
   int variable_index;
   int justification_start;
+  int justification_end;
+    // the formulas added to expand this constraint; both are -1 if
+    // the constraint has not been expanded yet
 
-  HorpoConstraint(PTerm _left, PTerm _right, string _relation,
+  HorpoConstraint(PTerm _left, PTerm _right, HorpoRelation _relation,
                   PTerm _resterm, int _resnum, int _varindex);
 
   ~HorpoConstraint();
 };
 
+struct TermEntry {
+  PTerm term;
+  unsigned int hash;
+  int id;
+};
+  // an entry in the term table of a HorpoConstraintList
+
 
 class HorpoConstraintList {
   private:
     vector<PFormula> formulas;
     vector<HorpoConstraint*> constraints;
-    int handled;
     Horpo *master;
     Environment environment;
       // used for printing the meta-variables in the constraints;
       // these must be consistently printed with the same names
 
-    map<string,int> constraint_lookup;
+    vector<TermEntry*> term_table;
+    int number_terms;
+      // open addressing hash table of the terms in the constraints,
+      // which assigns the same identifier to alpha-equal terms
+    vector<int> constraint_table;
+      // open addressing hash table of the indexes of the constraints,
+      // keyed by the identifiers of their terms and the relation
 
-    string print_horpo_constraint(PTerm left, PTerm right, string relation,
-                                  PTerm resterm, int resnum);
+    string relation_string(HorpoRelation relation);
     string print_horpo_constraint(HorpoConstraint *constraint);
-    int add_constraint(PTerm left, PTerm right, string relation,
+    unsigned int term_hash(PTerm term, set<long> &bound);
+      // returns a hash which is the same for alpha-equal terms; bound
+      // contains the variables bound above term
+    int find_term(PTerm term, unsigned int hash);
+      // returns the identifier of a stored term alpha-equal to term,
+      // or -1 if there is none
+    int term_id(PTerm term);
+      // returns the identifier of term, storing it if necessary; a
+      // stored term must live as long as the list, so should be part
+      // of a constraint
+    void insert_term(TermEntry *entry);
+    unsigned int constraint_hash(int left, int right,
+                                 HorpoRelation relation, int restriction,
+                                 int resnum);
+    int find_constraint(int left, int right, HorpoRelation relation,
+                        int restriction, int resnum);
+      // returns the index in the constraint list of the constraint
+      // with the given term identifiers, or -1 if there is none
+    void insert_constraint(int index);
+    int add_constraint(PTerm left, PTerm right, HorpoRelation relation,
                        PTerm resterm, int resnum);
-    int index_of_constraint(PTerm left, PTerm right, string relation,
-                            PTerm resterm, int resnum);
+    int index_of_constraint(PTerm left, PTerm right,
+                            HorpoRelation relation, PTerm resterm,
+                            int resnum);
       // looks up the index of the given constraint, possibly adding
       // it if it doesn't exist yet; this is the index in the constraint
       // list
-    int var_for_constraint(PTerm left, PTerm right, string relation,
+    int var_for_constraint(PTerm left, PTerm right, HorpoRelation relation,
                            PTerm resterm = NULL, int resnum = 0);
       // looks up the value of variable_index corresponding to the
       // given constraint (adding the constraint if necessary)
 
+    void expand(int i, map<string,int> &arities);
+      // adds the formulas which justify constraints[i]; this may
+      // create new (unexpanded) constraints
+    void handle_constraint(HorpoConstraint *constraint,
+                           map<string,int> &arities);
+      // does the work for expand
     void handle_greater(PTerm left, PTerm right, int index);
     void handle_basic_geq(PTerm left, PTerm right, int index);
     void handle_standard_right(PTerm left, PTerm right, int index,
@@ -119,11 +167,20 @@ class HorpoConstraintList {
     void simplify(map<string,int> &arities);
       // goes through all constraints, and marks them as done after
       // adding suitable clauses to the list of formulas
+    bool expand_true(map<string,int> &arities, int depth);
+      // expands those constraints which have not been expanded yet,
+      // but whose variable is true in the current valuation, along
+      // with the constraints this creates up to the given depth;
+      // returns false if there are no such constraints
+    void exclude_unexpanded();
+      // sets the variables of all constraints which have not been
+      // expanded to false
     void add_formula(PFormula formula);
     And *generate_complete_formula();
       // creates the conjunction of the added formulas; this is a
       // copy, so may be manipulated as the caller sees fit
-    int query_constraint_variable(PTerm left, PTerm right, string relation);
+    int query_constraint_variable(PTerm left, PTerm right,
+                                  HorpoRelation relation);
       // returns the variable associated to the given constraint; the
       // constraint MUST already exist before this is called!
     HorpoConstraint *constraint_by_index(int index);
@@ -133,7 +190,7 @@ class HorpoConstraintList {
       // given a variable index for an existing constraint, returns
       // the formulas which were generated to simplify that constraint
     vector<int> constraint_variables();
-      // list all variables used for a constraint
+      // list all variables used for an expanded constraint
     string print();
       // returns debugging information
 };
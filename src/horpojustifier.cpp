@@ -493,7 +493,7 @@ void HorpoJustifier :: justify(int variable, int &justifyindex,
       continue;
     }
 
-    if (description.substr(0,11) == "constraint " &&
+    if (description == "constraint" &&
         atom->query_variable()) {
       PTerm l, r;
       string rel, rul;
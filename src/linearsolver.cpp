@@ -0,0 +1,192 @@
+/**************************************************************************
+   Copyright 2019 Cynthia Kop
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "linearsolver.h"
+
+LinearSolver :: LinearSolver(vector<int> &mins, vector<int> &maxs) {
+  minima.insert(minima.end(), mins.begin(), mins.end());
+  maxima.insert(maxima.end(), maxs.begin(), maxs.end());
+}
+
+void LinearSolver :: set_hints(vector<int> &h) {
+  hints = h;
+}
+
+int LinearSolver :: add_constraint(PPol left, PPol right) {
+  map<int,int> coefs;
+  int constant = 0;
+  if (!add_polynomial(left, 1, coefs, constant)) return -1;
+  if (!add_polynomial(right, -1, coefs, constant)) return -1;
+
+  LinearConstraint c;
+  c.constant = constant;
+  for (map<int,int>::iterator it = coefs.begin(); it != coefs.end(); it++) {
+    if (it->second == 0) continue;
+    c.unknowns.push_back(it->first);
+    c.coefficients.push_back(it->second);
+  }
+  constraints.push_back(c);
+  return constraints.size() - 1;
+}
+
+bool LinearSolver :: add_polynomial(PPol p, int sign, map<int,int> &coefs,
+                                    int &constant) {
+  if (p->query_integer()) {
+    constant += sign * dynamic_cast<Integer*>(p)->query_value();
+    return true;
+  }
+
+  if (p->query_unknown()) {
+    int index = dynamic_cast<Unknown*>(p)->query_index();
+    if (index >= minima.size()) return false;
+    coefs[index] += sign;
+    return true;
+  }
+
+  if (p->query_sum()) {
+    for (int i = 0; i < p->number_children(); i++) {
+      if (!add_polynomial(p->get_child(i), sign, coefs, constant))
+        return false;
+    }
+    return true;
+  }
+
+  if (p->query_product()) {
+    // a product is linear if at most one of its factors is not an
+    // integer, and that factor is linear itself
+    int multiplier = sign;
+    PPol rest = NULL;
+    for (int i = 0; i < p->number_children(); i++) {
+      PPol child = p->get_child(i);
+      if (child->query_integer())
+        multiplier *= dynamic_cast<Integer*>(child)->query_value();
+      else if (rest == NULL) rest = child;
+      else return false;
+    }
+    if (rest == NULL) { constant += multiplier; return true; }
+    return add_polynomial(rest, multiplier, coefs, constant);
+  }
+
+  return false;
+}
+
+LinearResult LinearSolver :: check(vector<int> &active,
+                                   vector<int> &values) {
+  vector<int> lo = minima, hi = maxima;
+  for (int i = 0; i < lo.size(); i++) {
+    if (lo[i] > hi[i]) return LINEAR_UNSAT;
+  }
+
+  nodes = 0;
+  LinearResult result = search(active, lo, hi);
+  if (result == LINEAR_SAT) values = lo;
+  return result;
+}
+
+vector<int> LinearSolver :: explain(vector<int> &active) {
+  vector<int> core = active;
+  vector<int> dummy;
+
+  // deletion-based minimisation: leave out each constraint in turn,
+  // and drop it for good if the others are still unsatisfiable
+  for (int i = 0; i < core.size(); ) {
+    vector<int> attempt;
+    attempt.insert(attempt.end(), core.begin(), core.begin() + i);
+    attempt.insert(attempt.end(), core.begin() + i + 1, core.end());
+    if (check(attempt, dummy) == LINEAR_UNSAT) core = attempt;
+    else i++;
+  }
+
+  return core;
+}
+
+bool LinearSolver :: propagate(vector<int> &active, vector<int> &lo,
+                               vector<int> &hi) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 0; i < active.size(); i++) {
+      LinearConstraint &c = constraints[active[i]];
+      int j, n = c.unknowns.size();
+
+      // the highest value the left-hand side can take
+      int best = c.constant;
+      for (j = 0; j < n; j++) {
+        int coef = c.coefficients[j], x = c.unknowns[j];
+        best += coef * (coef > 0 ? hi[x] : lo[x]);
+      }
+      if (best < 0) return false;
+
+      // every unknown must be chosen so the rest can make up for it
+      for (j = 0; j < n; j++) {
+        int coef = c.coefficients[j], x = c.unknowns[j];
+        if (coef > 0) {
+          int newlo = hi[x] - best / coef;
+          if (newlo > lo[x]) { lo[x] = newlo; changed = true; }
+        }
+        else {
+          int newhi = lo[x] + best / (-coef);
+          if (newhi < hi[x]) { hi[x] = newhi; changed = true; }
+        }
+        if (lo[x] > hi[x]) return false;
+      }
+    }
+  }
+  return true;
+}
+
+LinearResult LinearSolver :: search(vector<int> &active, vector<int> &lo,
+                                    vector<int> &hi) {
+  if (++nodes > LINEAR_SEARCH_LIMIT) return LINEAR_UNKNOWN;
+  if (!propagate(active, lo, hi)) return LINEAR_UNSAT;
+
+  // find the undetermined unknown with the smallest range
+  int x = -1;
+  for (int i = 0; i < active.size(); i++) {
+    LinearConstraint &c = constraints[active[i]];
+    for (int j = 0; j < c.unknowns.size(); j++) {
+      int y = c.unknowns[j];
+      if (lo[y] == hi[y]) continue;
+      if (x == -1 || hi[y] - lo[y] < hi[x] - lo[x]) x = y;
+    }
+  }
+  if (x == -1) return LINEAR_SAT;
+
+  // first try x = lo[x], then x > lo[x]; if there is a hint for x,
+  // try that value first, and then the values below and above it
+  vector< pair<int,int> > ranges;
+  int hint = x < hints.size() ? hints[x] : -1;
+  if (hint > lo[x] && hint <= hi[x]) {
+    ranges.push_back(make_pair(hint, hint));
+    ranges.push_back(make_pair(lo[x], hint - 1));
+    if (hint < hi[x]) ranges.push_back(make_pair(hint + 1, hi[x]));
+  }
+  else {
+    ranges.push_back(make_pair(lo[x], lo[x]));
+    ranges.push_back(make_pair(lo[x] + 1, hi[x]));
+  }
+
+  LinearResult ret = LINEAR_UNSAT;
+  for (int k = 0; k < ranges.size(); k++) {
+    vector<int> sublo = lo, subhi = hi;
+    sublo[x] = ranges[k].first;
+    subhi[x] = ranges[k].second;
+    LinearResult result = search(active, sublo, subhi);
+    if (result == LINEAR_SAT) { lo = sublo; return LINEAR_SAT; }
+    if (result == LINEAR_UNKNOWN) ret = LINEAR_UNKNOWN;
+  }
+  return ret;
+}
@@ -0,0 +1,93 @@
+/**************************************************************************
+   Copyright 2019 Cynthia Kop
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef LINEARSOLVER_H
+#define LINEARSOLVER_H
+
+#include "polynomial.h"
+
+#define LINEAR_SEARCH_LIMIT 20000
+  // the maximum number of search nodes for a single feasibility check
+#define LINEAR_MAX_ROUNDS 64
+  // the maximum number of sat calls in the lazy solving loop of Smt
+#define LINEAR_MAX_CONFLICTS 8
+  // the maximum number of conflicts excluded after a single sat call
+
+enum LinearResult { LINEAR_SAT, LINEAR_UNSAT, LINEAR_UNKNOWN };
+
+/**
+ * This class decides conjunctions of linear inequalities
+ * c1*a1 + ... + cn*an + k >= 0 over unknowns ranging over bounded
+ * intervals of the natural numbers.  It is used as the theory solver
+ * when the polynomial constraints contain no products of unknowns:
+ * the boolean structure is left to the sat-solver, and only the
+ * inequalities which it selects are checked here.
+ *
+ * Feasibility is checked by branch-and-bound: the bounds of all
+ * unknowns are tightened by interval propagation over the selected
+ * inequalities, and if this does not fix every unknown, the one with
+ * the smallest remaining range is split into its lowest value and
+ * the rest.  Low values are tried first, as in the other solvers,
+ * unless a hint suggests a different value for the unknown.
+ */
+
+struct LinearConstraint {
+  vector<int> unknowns;
+  vector<int> coefficients;
+  int constant;
+};
+
+class LinearSolver {
+  private:
+    vector<int> minima;
+    vector<int> maxima;
+    vector<int> hints;
+    vector<LinearConstraint> constraints;
+    int nodes;
+
+    bool add_polynomial(PPol p, int sign, map<int,int> &coefs,
+                        int &constant);
+      // adds sign * p to the linear form given by coefs and constant;
+      // returns false if p is not linear
+    bool propagate(vector<int> &active, vector<int> &lo,
+                   vector<int> &hi);
+      // tightens the bounds lo and hi using the given constraints,
+      // until nothing changes anymore; returns false if a constraint
+      // cannot be satisfied within the bounds
+    LinearResult search(vector<int> &active, vector<int> &lo,
+                        vector<int> &hi);
+      // branch-and-bound search for a solution within lo and hi; on
+      // success, lo contains the solution
+
+  public:
+    LinearSolver(vector<int> &mins, vector<int> &maxs);
+
+    void set_hints(vector<int> &hints);
+      // gives for each unknown a value to try before the others (or
+      // -1 to just try the lowest value first)
+    int add_constraint(PPol left, PPol right);
+      // registers the constraint left >= right and returns its index,
+      // or -1 if left or right is not a linear polynomial in the
+      // unknowns
+    LinearResult check(vector<int> &active, vector<int> &values);
+      // checks whether the given constraints can be satisfied
+      // together; if so, values is set to a solution
+    vector<int> explain(vector<int> &active);
+      // given an unsatisfiable set of constraints, returns a smaller
+      // subset which is still unsatisfiable
+};
+
+#endif
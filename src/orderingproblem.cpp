@@ -155,7 +155,11 @@ const vector<PFormula> OrderingProblem :: query_constraints() {
 }
 
 const vector<OrderRequirement*> OrderingProblem :: orientables() {
-  return reqs;
+  vector<OrderRequirement*> ret;
+  for (int i = 0; i < reqs.size(); i++) {
+    if (!reqs[i]->query_dropped()) ret.push_back(reqs[i]);
+  }
+  return ret;
 }
 
 vector<int> OrderingProblem :: strictly_oriented() {
@@ -177,6 +181,7 @@ void OrderingProblem :: justify_orientables() {
 void OrderingProblem :: print() {
   wout.start_table();
   for (int i = 0; i < reqs.size(); i++) {
+    if (reqs[i]->query_dropped()) continue;
     map<int,string> metanaming, freenaming, boundnaming;
     vector<string> entry;
     Valuation val = reqs[i]->condition_valuation();
@@ -202,7 +207,7 @@ void OrderingProblem :: print() {
 PlainOrderingProblem :: PlainOrderingProblem(Ruleset &rules, Alphabet &F,
                                              bool allow_arities,
                                              bool order_all)
-  :OrderingProblem(rules, F) {
+  :OrderingProblem(rules, F), arities_allowed(allow_arities) {
 
   // if we are not allowed to calculate arities, set them all to 0
   if (!allow_arities) {
@@ -227,6 +232,28 @@ PlainOrderingProblem :: PlainOrderingProblem(Ruleset &rules, Alphabet &F,
   else require_atleastone(base, vars.query_size() - 1);
 }
 
+void PlainOrderingProblem :: drop_rule(int index) {
+  int i;
+
+  // the strictness variable of the rule may no longer be chosen
+  int var = reqs[index]->drop();
+  constraints.push_back(new AntiVar(var));
+
+  // the remaining rules might admit larger arities
+  arities.clear();
+  for (i = 0; i < reqs.size(); i++) {
+    if (reqs[i]->query_dropped()) continue;
+    reqs[i]->left->adjust_arities(arities);
+    reqs[i]->right->adjust_arities(arities);
+  }
+  if (!arities_allowed) {
+    for (map<string,int>::iterator it = arities.begin();
+         it != arities.end(); it++) {
+      it->second = 0;
+    }
+  }
+}
+
 
 DPOrderingProblem :: DPOrderingProblem(DPSet &dps, Ruleset &rules,
                                        Alphabet &F, bool &use_tagging,
@@ -135,7 +135,8 @@ class OrderingProblem {
       // the filter variables
 
     const vector<OrderRequirement*> orientables();
-      // returns the list of requirements we must orient
+      // returns the list of requirements we must orient; requirements
+      // which have been dropped are left out
 
     bool unfilterable(string symbol);
       // returns true if the given symbol MAY NOT be filtered,
@@ -177,9 +178,18 @@ class OrderingProblem {
  * is ordered strictly -- or all of them are, if this is requested
  */
 class PlainOrderingProblem : public OrderingProblem {
+  private:
+    bool arities_allowed;
+
   public:
     PlainOrderingProblem(Ruleset &rules, Alphabet &F,
                          bool allow_arities, bool order_all);
+
+    void drop_rule(int index);
+      // removes the requirement for the given rule (counting from 0
+      // in the ruleset the problem was created with), so the problem
+      // can be reused for the remaining rules; this does not change
+      // the variables used for the other requirements
 };
 
 /**
@@ -17,6 +17,7 @@
 #include "outputmodule.h"
 #include "afs.h"
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 
@@ -262,6 +263,66 @@ void OutputModule :: succeed_method(string method) {
   methods[methods.size()-1].cites.insert(cites.begin(), cites.end());
 }
 
+/* =============== FORKED PROCESSES =============== */
+
+/* adds txt to data in such a way that read_field can recover it */
+static void write_field(string &data, string txt) {
+  char len[20];
+  sprintf(len, "%d:", (int)txt.length());
+  data += len + txt;
+}
+
+/* reads a field written by write_field at position pos of data */
+static string read_field(string &data, int &pos) {
+  int k = data.find(':', pos);
+  if (k == string::npos) { pos = data.length(); return ""; }
+  int len = atoi(data.substr(pos, k - pos).c_str());
+  pos = k + 1 + len;
+  return data.substr(k + 1, len);
+}
+
+void OutputModule :: mark_progress() {
+  marked_output.push_back(methods[methods.size()-1].output.length());
+  marked_formal.push_back(formal_output.length());
+}
+
+string OutputModule :: export_progress() {
+  if (paragraph_open) print("\n");
+  Method &current = methods[methods.size()-1];
+  string data, cites;
+  for (set<string>::iterator it = current.cites.begin();
+       it != current.cites.end(); it++) {
+    write_field(cites, *it);
+  }
+  write_field(data, current.output.substr(marked_output.back()));
+  write_field(data, formal_output.substr(marked_formal.back()));
+  write_field(data, cites);
+  marked_output.pop_back();
+  marked_formal.pop_back();
+  return data;
+}
+
+string OutputModule :: take_progress() {
+  if (paragraph_open) print("\n");
+  int output_mark = marked_output.back();
+  int formal_mark = marked_formal.back();
+  string data = export_progress();
+  methods[methods.size()-1].output.erase(output_mark);
+  formal_output.erase(formal_mark);
+  return data;
+}
+
+void OutputModule :: import_progress(string data) {
+  if (paragraph_open) print("\n");
+  int pos = 0;
+  methods[methods.size()-1].output += read_field(data, pos);
+  formal_output += read_field(data, pos);
+  string cites = read_field(data, pos);
+  for (pos = 0; pos < cites.length(); ) {
+    methods[methods.size()-1].cites.insert(read_field(cites, pos));
+  }
+}
+
 /* =============== BOXES =============== */
 
 void OutputModule :: start_box() {
@@ -46,6 +46,8 @@ class OutputModule {
     bool paragraph_open;
     bool box_open;
     string formal_output;
+    vector<int> marked_output;
+    vector<int> marked_formal;
 
     vector<Method> methods;
 
@@ -164,6 +166,27 @@ class OutputModule {
     void abort_method(string method);
     void succeed_method(string method);
 
+    /* dealing with forked processes */
+
+    // a process forked to do part of the work can send everything it
+    // printed back to its parent, which adds it to its own output as
+    // if it had been printed there; any methods started after the
+    // mark must have been closed before exporting; marks may be
+    // nested, and each mark should be exported once
+
+    void mark_progress();
+      // remembers the current point in the output
+    string export_progress();
+      // returns everything printed since the last mark which has not
+      // been exported yet, in the form read by import_progress, and
+      // forgets that mark
+    string take_progress();
+      // like export_progress, but also removes what was printed since
+      // the mark, so it can be imported again at a later point
+    void import_progress(string data);
+      // adds output obtained from export_progress to the current
+      // method
+
     /* dealing with "boxes" */
 
     // if you start a box, anything printed is put in a grey box in
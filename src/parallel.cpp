@@ -0,0 +1,187 @@
+/**************************************************************************
+   Copyright 2019 Cynthia Kop
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "parallel.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#define MAX_LIVE_WORKERS 256
+
+/**
+ * When a worker is cancelled, it should stop the workers it started
+ * itself as well, and clean up after itself; as this happens in a
+ * signal handler, the relevant data is kept in plain arrays.
+ */
+static pid_t live_workers[MAX_LIVE_WORKERS];
+static int live_count = 0;
+static char own_files[3][64];
+static const char *file_kinds[] = {"input", "output", "worker"};
+
+static void stop_worker(int signal) {
+  for (int i = 0; i < live_count; i++) kill(-live_workers[i], SIGTERM);
+  for (int i = 0; i < 3; i++) unlink(own_files[i]);
+  _exit(1);
+}
+
+static void forget_worker(int pid) {
+  for (int i = 0; i < live_count; i++) {
+    if (live_workers[i] != pid) continue;
+    live_workers[i] = live_workers[--live_count];
+    return;
+  }
+}
+
+/* removes the files which the given process may have left behind */
+static void remove_private_files(int pid) {
+  char name[64];
+  for (int i = 0; i < 3; i++) {
+    sprintf(name, "resources/%s.%d", file_kinds[i], pid);
+    remove(name);
+  }
+}
+
+void WorkerPool :: clean_up_on_termination() {
+  for (int i = 0; i < 3; i++) {
+    sprintf(own_files[i], "resources/%s.%d", file_kinds[i], getpid());
+  }
+  signal(SIGTERM, stop_worker);
+}
+
+WorkerPool :: WorkerPool(int _max_workers) :max_workers(_max_workers) {}
+
+WorkerPool :: ~WorkerPool() {
+  cancel();
+}
+
+bool WorkerPool :: full() {
+  return running.size() >= max_workers;
+}
+
+bool WorkerPool :: start(int task) {
+  cout.flush();
+  int pid = fork();
+  if (pid == 0) {
+    setpgid(0, 0);
+    live_count = 0;
+    clean_up_on_termination();
+#ifdef __linux__
+    // don't outlive the parent if it is stopped by a timeout
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    if (getppid() == 1) stop_worker(SIGTERM);
+#endif
+    return true;
+  }
+  if (pid < 0) failed_to_start[task] = true;
+  else {
+    setpgid(pid, pid);
+    running[pid] = task;
+    if (live_count < MAX_LIVE_WORKERS) live_workers[live_count++] = pid;
+  }
+  return false;
+}
+
+void WorkerPool :: finish(bool success, string data) {
+  ofstream file(private_file("worker").c_str());
+  file << data;
+  file.close();
+  _exit(success ? 0 : 1);
+}
+
+bool WorkerPool :: take_failure(int task) {
+  if (failed_to_start.find(task) == failed_to_start.end()) return false;
+  failed_to_start.erase(task);
+  return true;
+}
+
+bool WorkerPool :: wait(int &task, bool &success, string &data,
+                         int limit) {
+  if (!failed_to_start.empty()) {
+    task = failed_to_start.begin()->first;
+    failed_to_start.erase(failed_to_start.begin());
+    success = false;
+    data = "";
+    return true;
+  }
+
+  // only our own workers are waited for, since other children of
+  // this process (such as external tools) are reaped elsewhere
+  int waited = 0, pid = 0, status = 0;
+  while (!running.empty()) {
+    for (map<int,int>::iterator it = running.begin();
+         it != running.end() && pid == 0; it++) {
+      pid = waitpid(it->first, &status, WNOHANG);
+      // a worker which cannot be waited for has been lost
+      if (pid < 0) { pid = it->first; status = -1; }
+    }
+    if (pid != 0) break;
+    if (limit >= 0 && waited >= limit) return false;
+    usleep(10000);
+    waited += 10;
+  }
+  if (pid == 0) return false;
+
+  task = running[pid];
+  running.erase(pid);
+  forget_worker(pid);
+  success = status >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+  char name[40];
+  sprintf(name, "resources/worker.%d", pid);
+  ifstream file(name);
+  stringstream contents;
+  contents << file.rdbuf();
+  data = contents.str();
+  file.close();
+  remove_private_files(pid);
+  return true;
+}
+
+void WorkerPool :: cancel() {
+  for (map<int,int>::iterator it = running.begin();
+       it != running.end(); it++) {
+    kill(-it->first, SIGTERM);
+  }
+  for (map<int,int>::iterator it = running.begin();
+       it != running.end(); it++) {
+    waitpid(it->first, NULL, 0);
+    forget_worker(it->first);
+    remove_private_files(it->first);
+  }
+  running.clear();
+  failed_to_start.clear();
+}
+
+long WorkerPool :: milliseconds() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec * 1000L + now.tv_usec / 1000;
+}
+
+string WorkerPool :: private_file(string name) {
+  char suffix[20];
+  sprintf(suffix, ".%d", getpid());
+  return "resources/" + name + suffix;
+}
@@ -0,0 +1,84 @@
+/**************************************************************************
+   Copyright 2019 Cynthia Kop
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <map>
+#include <string>
+using namespace std;
+
+/**
+ * This class runs independent tasks in forked processes.  Most of
+ * wanda's components share global state (the valuation of the sat
+ * variables, the output module and the files used to communicate
+ * with external tools), so rather than threads, every task gets a
+ * copy of the whole process.  When done, a worker reports success
+ * or failure, along with a string from which the parent can
+ * reconstruct whatever it needs of the worker's results.
+ *
+ * Workers are placed in their own process group, so cancelling a
+ * worker also stops any external tool it is running, and a cancelled
+ * worker in turn cancels the workers it started itself.
+ */
+
+class WorkerPool {
+  private:
+    int max_workers;
+    map<int,int> running;
+      // maps the process ids of the running workers to their tasks
+    map<int,bool> failed_to_start;
+      // tasks for which no process could be forked
+
+  public:
+    WorkerPool(int max_workers);
+    ~WorkerPool();
+      // cancels all workers which are still running
+
+    bool full();
+      // returns whether the maximum number of workers is running
+
+    bool start(int task);
+      // forks a worker for the given task; like fork(), this returns
+      // in both processes: true in the worker, which should do the
+      // task and call finish, and false in the parent
+    static void finish(bool success, string data);
+      // used by a worker to report its results and exit
+
+    bool take_failure(int task);
+      // returns whether no worker could be forked for the given task;
+      // if so, the caller takes responsibility for the task, and wait
+      // will not report it
+    bool wait(int &task, bool &success, string &data, int limit = -1);
+      // waits for some worker to finish, and stores its task and
+      // results; returns false if no workers remain, or if a
+      // non-negative limit is given and no worker finishes within
+      // that many milliseconds
+    void cancel();
+      // stops all running workers; their results are discarded
+
+    static long milliseconds();
+      // returns the current time in milliseconds, for deadlines
+
+    static string private_file(string name);
+      // returns the name of a file in the resources directory which
+      // is used only by the current process
+    static void clean_up_on_termination();
+      // makes sure that when the current process is terminated, it
+      // stops its workers and removes its private files
+};
+
+#endif
@@ -17,6 +17,7 @@
 #include "outputmodule.h"
 #include "polconstraintlist.h"
 #include "polymodule.h"
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 
@@ -333,18 +334,15 @@ bool PolConstraintList :: split_max(PPol left, PPol right,
     return true;
   }
 
-  // second (more important) case: right contains a max
-  if (rightcontains) {
-    PPol right_split = split_max(newright, greater, smaller);
-    if (right_split == NULL) return false;
-    account_for_greater(greater, smaller, right_split);
-    account_for_smaller(greater, smaller, newright);
-    newright = newright->simplify();
-    right_split = right_split->simplify();
-    int cindex = var_for_constraint(newleft->copy(), right_split);
-    add_formula(new Or(new AntiVar(vindex), new Var(cindex)));
-  }
-
+  // second (more important) case: right contains a max; rather than
+  // splitting into a case for every way to choose the arguments of
+  // the maxes, we replace each max by a polynomial dominating all its
+  // arguments, so the number of constraints stays linear
+  // note that this is weaker than the split when maxes are multiplied:
+  // max(x,y) * max(x,y) becomes x^2 + 2xy + y^2, which needs xy twice
+  // where the split needs it once; the same holds where groups with
+  // functionals (or coefficients without a known bound) are summed
+  newright = dominate_max(newright, vindex)->simplify();
   add_formula(new Or(new AntiVar(vindex),
                      new Var(var_for_constraint(newleft, newright))));
   return true;
@@ -402,86 +400,126 @@ PPol PolConstraintList :: split_max(PPol pol, PPol &greater,
   return NULL;
 }
 
-void PolConstraintList :: account_for_greater(PPol &greater, vector<PPol>
-                                               &smaller, PPol &pol) {
-  int i, j, k;
-  for (i = 0; i < pol->number_children(); i++) {
-    PPol c = pol->get_child(i);
-    account_for_greater(greater, smaller, c);
+PPol PolConstraintList :: dominate_max(PPol pol, int vindex) {
+  int i;
+
+  if (pol->query_sum() || pol->query_product()) {
+    for (i = 0; i < pol->number_children(); i++)
+      pol->replace_child(i, dominate_max(pol->get_child(i), vindex));
+    return pol;
   }
 
-  if (!pol->query_max()) return;
+  if (!pol->query_max()) return pol;
 
-  /* Note the following:
-   * both [greater,smaller1,...,smallern], and the children of pol,
-   * are ordered by rating, smaller ratings first.
-   * So if greater < child i, it will also be < all next children.
-   * Moreover, it child i = greater, and child j = smaller k, then
-   * it must hold that i < j.
-   */
+  vector<PPol> parts;
+  for (i = 0; i < pol->number_children(); i++)
+    parts.push_back(dominate_max(pol->get_child(i)->copy(), vindex)->
+                    simplify());
+  delete pol;
 
-  for (i = 0; i < pol->number_children(); i++) {
-    int cmp = pol->get_child(i)->compare(greater);
-    if (cmp == -1) return;
-    if (cmp == 1) continue;
-    // child i = greater! See whether any of smaller are represented!
-
-    k = 0;
-    for (j = i+1; j < pol->number_children(); j++) {
-      PPol child = pol->get_child(j);
-      for (; k < smaller.size(); k++) {
-        cmp = child->compare(smaller[k]);
-        if (cmp == -1) break;
-        if (cmp == 1) continue;
-        // child j = smaller[k]!
-        delete dynamic_cast<Max*>(pol)->replace_child(j, new Integer(0));
-        break;
+  // go over the monomials by their variables and functionals, and
+  // take a coefficient at least as large as in each part
+  Sum *ret = new Sum();
+  bool done = false;
+  while (!done) {
+    vector<int> combination;
+    for (i = 0; i < parts.size() && combination.size() == 0; i++)
+      combination = find_combination(parts[i]);
+    done = combination.size() == 0;
+
+    vector<PPol> group;
+    bool functional = false;
+    for (i = 0; i < parts.size(); i++) {
+      PPol p = remove_parts(parts[i], combination);
+      parts[i] = parts[i]->simplify();
+      if (p->query_integer() &&
+          dynamic_cast<Integer*>(p)->query_value() == 0) delete p;
+      else {
+        group.push_back(p);
+        functional |= contains_functional(p);
       }
     }
+
+    // the new coefficient must be able to reach every coefficient in
+    // the group, so its range follows from theirs
+    int bound = 0;
+    for (i = 0; i < group.size() && !functional && bound >= 0; i++) {
+      PPol coefficient = coefficient_part(group[i]);
+      int sub = master->upper_bound(coefficient);
+      bound = sub < 0 ? -1 : max(bound, sub);
+      delete coefficient;
+    }
+
+    // functionals cannot be combined this way (their arguments may
+    // differ), but their sum is an upper bound as well
+    if (group.size() == 1 || functional || bound < 0) {
+      for (i = 0; i < group.size(); i++) ret->add_child(group[i]);
+      continue;
+    }
+    if (group.size() == 0) continue;
+
+    Unknown *coef = master->new_unknown(bound);
+    for (i = 0; i < group.size(); i++) {
+      int cnum = var_for_constraint(coef->copy(),
+                                    coefficient_part(group[i])->simplify());
+      add_formula(new Or(new AntiVar(vindex), new Var(cnum)));
+    }
+    ret->add_child(new Product(coef, variable_part(group[0])));
+    for (i = 0; i < group.size(); i++) delete group[i];
   }
+
+  for (i = 0; i < parts.size(); i++) delete parts[i];
+  return ret;
 }
 
-void PolConstraintList :: account_for_smaller(PPol &greater, vector<PPol>
-                                              &smaller, PPol &pol) {
-  int i, j, k;
-  for (i = 0; i < pol->number_children(); i++) {
-    PPol c = pol->get_child(i);
-    account_for_smaller(greater, smaller, c);
-  }
+bool PolConstraintList :: contains_functional(PPol pol) {
+  if (pol->query_functional()) return true;
+  if (pol->query_sum() || pol->query_product())
+    for (int i = 0; i < pol->number_children(); i++)
+      if (contains_functional(pol->get_child(i))) return true;
+  return false;
+}
 
-  if (!pol->query_max()) return;
+PPol PolConstraintList :: coefficient_part(PPol pol) {
+  if (pol->query_variable()) return new Integer(1);
 
-  /* Note the following:
-   * both [greater,smaller1,...,smallern], and the children of pol,
-   * are ordered by rating, smaller ratings first.
-   * So if greater < child i, it will also be < all next children.
-   * Moreover, it child i = greater, and child j = smaller k, then
-   * it must hold that i < j.
-   */
+  if (pol->query_sum()) {
+    Sum *ret = new Sum();
+    for (int i = 0; i < pol->number_children(); i++)
+      ret->add_child(coefficient_part(pol->get_child(i)));
+    return ret;
+  }
 
-  for (i = 0; i < pol->number_children(); i++) {
-    int cmp = pol->get_child(i)->compare(greater);
-    if (cmp == -1) return;
-    if (cmp == 1) continue;
-    // child i = greater! See whether all of smaller are represented!
-
-    bool all_present = true;
-    k = 0;
-    for (j = i+1; j < pol->number_children(); j++) {
-      PPol child = pol->get_child(j);
-      bool ok = false;
-      for (; k < smaller.size() && !ok; k++) {
-        cmp = child->compare(smaller[k]);
-        if (cmp == -1) break;
-        if (cmp == 0) ok = true;
-      }
-      if (!ok) all_present = false;
+  if (pol->query_product()) {
+    Product *ret = new Product();
+    ret->add_child(new Integer(1));
+    for (int i = 0; i < pol->number_children(); i++) {
+      if (!pol->get_child(i)->query_variable())
+        ret->add_child(pol->get_child(i)->copy());
     }
+    return ret;
+  }
+
+  return pol->copy();
+}
+
+PPol PolConstraintList :: variable_part(PPol pol) {
+  if (pol->query_variable()) return pol->copy();
+
+  if (pol->query_sum() && pol->number_children() > 0)
+    return variable_part(pol->get_child(0));
 
-    if (!all_present) return;
-    // they're all here! Remove greater.
-    delete dynamic_cast<Max*>(pol)->replace_child(i, new Integer(0));
+  if (pol->query_product()) {
+    Product *ret = new Product();
+    ret->add_child(new Integer(1));
+    for (int i = 0; i < pol->number_children(); i++) {
+      if (pol->get_child(i)->query_variable())
+        ret->add_child(pol->get_child(i)->copy());
+    }
+    return ret;
   }
+
+  return new Integer(1);
 }
 
 // responsible for absolute positiveness
@@ -64,18 +64,18 @@ class PolConstraintList {
       // greater is set to a, and smaller to [b1,...,bn]
     bool contains_max(PPol pol);
       // returns whether a Max occurs anywhere in pol
-    void account_for_greater(PPol &greater, vector<PPol> &smaller,
-                             PPol &pol);
-      // given that greater >= all the polynomials in smaller,
-      // simplify Max occurrences in pol
-      // it is assumed that [greater,smaller1,...,smallern] is ordered
-      // by the compare function
-    void account_for_smaller(PPol &greater, vector<PPol> &smaller,
-                             PPol &pol);
-      // given that greater < some polynomial in smaller
-      // simplify Max occurrences in pol
-      // it is assumed that [greater,smaller1,...,smallern] is ordered
-      // by the compare function
+    PPol dominate_max(PPol pol, int vid);
+      // replaces every max(p1,...,pn) in pol (outside functionals) by
+      // a polynomial which is at least each pi if vid holds, adding
+      // the constraints which guarantee this; pol is consumed
+    bool contains_functional(PPol pol);
+      // returns whether a functional occurs in pol (outside functionals)
+    PPol coefficient_part(PPol pol);
+      // for pol a monomial or sum of monomials without functionals,
+      // returns a copy where all variables are replaced by 1
+    PPol variable_part(PPol pol);
+      // for pol a monomial or sum of monomials with the same
+      // variables, returns the product of these variables
     bool split_parts(PPol left, PPol right, int vid);
       // deals with absolute positiveness
     vector<int> find_combination(PPol pol);
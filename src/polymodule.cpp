@@ -18,21 +18,35 @@
 #include "outputmodule.h"
 #include "smt.h"
 #include "substitution.h"
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 
 PolyModule :: PolyModule()
-    : do_base_products(false),
-      constraints(this) {
+    : do_base_products(false), delay_products(false), encoded(false),
+      constraints(this), interpret_depth(0) {
 }
 
 PolyModule :: ~PolyModule() {
+  clear_interpretation_cache();
 }
 
 void PolyModule :: set_use_products(bool value) {
   do_base_products = value;
 }
 
+void PolyModule :: set_delay_products(bool value) {
+  delay_products = value;
+}
+
+void PolyModule :: set_candidate(PolyModel &values) {
+  candidate = values;
+}
+
+PolyModel PolyModule :: query_model() {
+  return model;
+}
+
 vector<int> PolyModule :: orient(OrderingProblem *prob) {
   int i;
   vector<int> ret;
@@ -52,7 +66,7 @@ vector<int> PolyModule :: orient(OrderingProblem *prob) {
   if (wout.query_verbose()) attempt = "will attempt to ";
   wout.print("We " + attempt + "orient these requirements with a "
     "polynomial interpretation in the natural numbers.\n");
-  if (wout.query_verbose() && !do_base_products)
+  if (wout.query_verbose() && (!do_base_products || delay_products))
     wout.print("We will not try to use product polynomials.\n");
 
   // save the constraints we must have by default
@@ -62,17 +76,83 @@ vector<int> PolyModule :: orient(OrderingProblem *prob) {
 
   arities = problem->arities;
   choose_interpretations();
-  interpret_requirements();
-  constraints.simplify();
-  if (wout.query_debugging()) {
-    wout.debug_print("The interpretation constraints are simplified "
-    "to:\n");
-    constraints.debug_print();
+
+  // often, one of a few simple interpretations will do, or the one
+  // found for a similar problem, and this can be checked without
+  // building constraints or calling the solver
+  bool success = simple_interpretation();
+  if (!success && !candidate.empty()) {
+    vector<int> hints = candidate_hints();
+    success = check_candidate(hints);
+  }
+
+  if (!success) {
+    interpret_requirements();
+    constraints.simplify();
+    if (wout.query_debugging()) {
+      wout.debug_print("The interpretation constraints are simplified "
+      "to:\n");
+      constraints.debug_print();
+    }
+    encoded = true;
+    success = solve_constraints();
   }
+
+  return finish(success);
+}
+
+vector<int> PolyModule :: enable_products() {
+  vector<int> ret;
+  if (!encoded || product_unknowns.empty()) return ret;
+
+  // the attempt without products was aborted, so its explanation must
+  // be given again
+  wout.start_method("polynomial interpretations");
+  string attempt = "";
+  if (wout.query_verbose()) attempt = "will attempt to ";
+  wout.print("We " + attempt + "orient these requirements with a "
+    "polynomial interpretation in the natural numbers, now also "
+    "allowing products of arguments.\n");
+  if (wout.query_verbose()) {
+    print_rows("We start with the following parametric "
+      "interpretations:\n", parametric_rows);
+    print_rows("This leads to the following parametric constraints.\n",
+      constraint_rows);
+  }
+
+  // the constraints were built with the products already in place, so
+  // we only need to let their coefficients be positive
+  for (int i = 0; i < product_unknowns.size(); i++)
+    maximum[product_unknowns[i]] = MAX_UNKNOWN;
+  delay_products = false;
+
+  return finish(solve_constraints());
+}
+
+bool PolyModule :: solve_constraints() {
   PFormula fullconstraints = constraints.generate_complete_formula();
+
+  // a candidate from a similar problem did not orient the
+  // requirements, but its values are still a good place to start
+  vector<int> hints = candidate_hints();
+  vector<int> values = minimum;
   Smt smtsolver(minimum, maximum);
+  smtsolver.set_hints(hints);
+  if (!smtsolver.solve(fullconstraints, values)) return false;
+  minimum = values;
+  return true;
+}
+
+vector<int> PolyModule :: finish(bool success) {
+  vector<int> ret;
 
-  if (smtsolver.solve(fullconstraints, minimum)) {
+  model.clear();
+  if (success) {
+    map<string, pair<int,int> >::iterator it;
+    for (it = symbol_unknowns.begin(); it != symbol_unknowns.end(); it++) {
+      model[it->first] = vector<int>(minimum.begin() + it->second.first,
+                                     minimum.begin() + it->second.second);
+    }
     ret = get_solution();
     wout.succeed_method("polynomial interpretations");
   }
@@ -83,6 +163,209 @@ vector<int> PolyModule :: orient(OrderingProblem *prob) {
   return ret;
 }
 
+vector<int> PolyModule :: candidate_hints() {
+  vector<int> hints(minimum.size(), -1);
+  map<string, pair<int,int> >::iterator it;
+  for (it = symbol_unknowns.begin(); it != symbol_unknowns.end(); it++) {
+    if (candidate.find(it->first) == candidate.end()) continue;
+    vector<int> &values = candidate[it->first];
+    int start = it->second.first;
+    // a different number of unknowns means a different shape
+    if (values.size() != it->second.second - start) continue;
+    for (int i = 0; i < values.size(); i++) {
+      if (values[i] >= minimum[start+i] && values[i] <= maximum[start+i])
+        hints[start+i] = values[i];
+    }
+  }
+  return hints;
+}
+
+bool PolyModule :: check_candidate(vector<int> &hints) {
+  vector<int> values = minimum;
+  for (int i = 0; i < hints.size(); i++) {
+    if (hints[i] >= 0) values[i] = hints[i];
+  }
+
+  vector<Valuation> saved = save_valuation();
+  if (try_values(values)) return true;
+  restore_valuation(saved);
+  return false;
+}
+
+vector<Valuation> PolyModule :: save_valuation() {
+  vector<Valuation> ret;
+  for (int i = 0; i < vars.query_size(); i++)
+    ret.push_back(vars.query_value(i));
+  return ret;
+}
+
+void PolyModule :: restore_valuation(vector<Valuation> &saved) {
+  vars.truncate(saved.size());
+  for (int i = 0; i < saved.size(); i++) vars.force_value(i, saved[i]);
+}
+
+/* =============== SIMPLE INTERPRETATIONS =============== */
+
+bool PolyModule :: simple_interpretation() {
+  vector<Valuation> saved = save_valuation();
+  for (int constant = 0; constant <= 1; constant++) {
+    if (simple_interpretation(constant)) return true;
+    restore_valuation(saved);
+  }
+  return false;
+}
+
+bool PolyModule :: simple_interpretation(int constant) {
+  int i;
+
+  // all coefficients are 1, except those of products, and every
+  // constant part is the given constant
+  vector<int> values(minimum.size(), 0);
+  for (i = 0; i < simple_ones.size(); i++) values[simple_ones[i]] = 1;
+  for (i = 0; i < simple_constants.size(); i++)
+    values[simple_constants[i]] = constant;
+  return try_values(values);
+}
+
+bool PolyModule :: try_values(vector<int> &values) {
+  int i, j;
+
+  // argument functions are interpreted by a max, which the simple
+  // comparison does not handle
+  if (!argfunid.empty()) return false;
+
+  for (i = 0; i < values.size(); i++) {
+    if (values[i] < minimum[i] || values[i] > maximum[i]) return false;
+  }
+  for (i = 0; i < essential_unknowns.size(); i++) {
+    for (j = 0; j < essential_unknowns[i].size(); j++)
+      if (values[essential_unknowns[i][j]] > 0) break;
+    if (j == essential_unknowns[i].size()) return false;
+  }
+
+  // nothing is filtered (which is always allowed)
+  bool ok = true;
+  for (ArList::iterator it = arities.begin(); it != arities.end() && ok;
+       it++) {
+    for (i = 1; i <= it->second && ok; i++) {
+      int var = problem->filtered_variable(it->first, i);
+      if (var >= 0) ok = force_simple(var, false);
+    }
+  }
+  if (!ok) return false;
+
+  map<int,PPol> substitution;
+  for (i = 0; i < values.size(); i++)
+    substitution[i] = new Integer(values[i]);
+
+  // orient the requirements one by one
+  vector<OrderRequirement*> reqs = problem->orientables();
+  for (i = 0; i < reqs.size() && ok; i++) {
+    PType type = reqs[i]->left->query_type();
+    vector<PolynomialFunction*> argvars1, argvars2;
+    while (type->query_composed()) {
+      int varid = unused_polvar_index();
+      argvars1.push_back(make_variable(type->query_child(0), varid));
+      argvars2.push_back(make_variable(type->query_child(0), varid));
+      type = type->query_child(1);
+    }
+    map<int,PolynomialFunction*> subst;
+    PPol l = interpret(reqs[i]->left, subst, argvars1);
+    PPol r = interpret(reqs[i]->right, subst, argvars2);
+    l = l->replace_unknowns(substitution)->simplify();
+    r = r->replace_unknowns(substitution)->simplify();
+    int comparison = simple_compare(l, r);
+    delete l;
+    delete r;
+
+    if (reqs[i]->definite_requirement()) {
+      PFormula greater = reqs[i]->orient_greater();
+      if (comparison == 0 || !greater->query_variable()) ok = false;
+      else ok = force_simple(dynamic_cast<Var*>(greater)->query_index(),
+                             comparison == 2);
+      delete greater;
+    }
+    else {
+      PFormula atall = reqs[i]->orient_at_all();
+      if (!atall->query_variable()) ok = (comparison != 0);
+      else ok = force_simple(dynamic_cast<Var*>(atall)->query_index(),
+                             comparison != 0);
+      delete atall;
+    }
+  }
+
+  for (map<int,PPol>::iterator it = substitution.begin();
+       it != substitution.end(); it++) delete it->second;
+  if (!ok) return false;
+
+  // the choices must satisfy the constraints of the problem, and
+  // orient something strictly
+  vector<PFormula> base = problem->query_constraints();
+  for (i = 0; i < base.size(); i++) {
+    PFormula form = base[i]->copy()->simplify();
+    bool top = form->query_top();
+    delete form;
+    if (!top) return false;
+  }
+  if (problem->strictly_oriented().empty()) return false;
+
+  for (i = 0; i < values.size(); i++) minimum[i] = maximum[i] = values[i];
+  return true;
+}
+
+bool PolyModule :: force_simple(int var, bool value) {
+  Valuation val = value ? TRUE : FALSE;
+  if (vars.query_value(var) == UNKNOWN) vars.force_value(var, val);
+  return vars.query_value(var) == val;
+}
+
+bool PolyModule :: simple_monomials(PPol pol, map<string,int> &coefs) {
+  if (pol->query_sum()) {
+    for (int i = 0; i < pol->number_children(); i++) {
+      if (!simple_monomials(pol->get_child(i), coefs)) return false;
+    }
+    return true;
+  }
+  if (pol->query_integer()) {
+    coefs[""] += dynamic_cast<Integer*>(pol)->query_value();
+    return true;
+  }
+  if (pol->query_variable() || pol->query_functional()) {
+    coefs[pol->to_string()] += 1;
+    return true;
+  }
+  if (pol->query_product()) {
+    int coef = 1;
+    string key = "";
+    for (int i = 0; i < pol->number_children(); i++) {
+      PPol child = pol->get_child(i);
+      if (child->query_integer())
+        coef *= dynamic_cast<Integer*>(child)->query_value();
+      else if (child->query_variable() || child->query_functional())
+        key += child->to_string() + "*";
+      else return false;
+    }
+    coefs[key] += coef;
+    return true;
+  }
+  return false;
+}
+
+int PolyModule :: simple_compare(PPol left, PPol right) {
+  map<string,int> lcoefs, rcoefs;
+  if (!simple_monomials(left, lcoefs)) return 0;
+  if (!simple_monomials(right, rcoefs)) return 0;
+
+  // as all values are natural numbers, left >= right certainly holds
+  // if every monomial of right is matched by one in left
+  for (map<string,int>::iterator it = rcoefs.begin();
+       it != rcoefs.end(); it++) {
+    if (lcoefs[it->first] < it->second) return 0;
+  }
+  if (lcoefs[""] > rcoefs[""]) return 2;
+  return 1;
+}
+
 /* =============== STARTUP CHECKS =============== */
 
 bool PolyModule :: monomorphic() {
@@ -142,6 +425,31 @@ Unknown *PolyModule :: new_unknown(int max) {
   return new Unknown(id);
 }
 
+int PolyModule :: upper_bound(PPol pol) {
+  if (pol->query_integer())
+    return dynamic_cast<Integer*>(pol)->query_value();
+
+  if (pol->query_unknown()) {
+    int index = dynamic_cast<Unknown*>(pol)->query_index();
+    // product coefficients are only unrestricted later on
+    if (delay_products && find(product_unknowns.begin(),
+        product_unknowns.end(), index) != product_unknowns.end())
+      return MAX_UNKNOWN;
+    return maximum[index];
+  }
+
+  if (!pol->query_sum() && !pol->query_product()) return -1;
+
+  int ret = pol->query_sum() ? 0 : 1;
+  for (int i = 0; i < pol->number_children(); i++) {
+    int sub = upper_bound(pol->get_child(i));
+    if (sub < 0) return -1;
+    if (pol->query_sum()) ret += sub;
+    else ret *= sub;
+  }
+  return ret;
+}
+
 PolynomialFunction *PolyModule :: make_variable(PType type, int id) {
   vector<int> vars;
 
@@ -248,8 +556,10 @@ void PolyModule :: choose_interpretations() {
     }
 
     // initalize the interpretation for the symbol    
+    symbol_unknowns[f].first = minimum.size();
     Sum *intp = new Sum();
     Unknown *sumbase = new_unknown();
+    simple_constants.push_back(sumbase->query_index());
     intp->add_child(sumbase);
 
     // deal with the #special-fun# symbols (argument functions)
@@ -284,6 +594,7 @@ void PolyModule :: choose_interpretations() {
     if (!special) for (j = 0; j < baseargs.size(); j++) {
       int k = baseargs[j];
       Unknown *a = new_unknown();
+      simple_ones.push_back(a->query_index());
       Polvar *x = new Polvar(varname[k]);
       intp->add_child(new Product(a, x));
       // if the ordering problem says it's not filterable, it has to
@@ -297,7 +608,8 @@ void PolyModule :: choose_interpretations() {
         for (int m = j+1; m < baseargs.size(); m++) {
           // TODO: try this with m = j as well, so also squares
           int n = baseargs[m];
-          a = new_unknown();
+          a = new_unknown(delay_products ? 0 : MAX_UNKNOWN);
+          product_unknowns.push_back(a->query_index());
           Polvar *x = new Polvar(varname[k]);
           Polvar *y = new Polvar(varname[n]);
           intp->add_child(new Product(a, new Product(x,y)));
@@ -313,7 +625,9 @@ void PolyModule :: choose_interpretations() {
       int k = funargs[j];
       int n = nargs[k];
       Unknown *a = new_unknown();
+      simple_ones.push_back(a->query_index());
       Sum *definitelynotfiltered = new Sum();
+      vector<int> used;
       vector<PPol> args;
 
       // create a * F(0,...,0)
@@ -324,12 +638,14 @@ void PolyModule :: choose_interpretations() {
       // the b * F(x1,...,xn) occurrences if not
       filter_check(f, k, a);
       definitelynotfiltered->add_child(a->copy());
+      used.push_back(a->query_index());
 
       // create everything of the form b * F(x1,...,xn) or
       // c * x1 * ... * xn * F(x1,...,xn)
       vector< vector<int> > combis = combinations(baseargs, n);
       for (int m = 0; m < combis.size(); m++) {
         Unknown *b = new_unknown(), *c = new_unknown();
+        simple_ones.push_back(b->query_index());
         int p;
         // we're not going to do this if any xi (or F) is filtered away
         filter_check(f, k, b);
@@ -344,6 +660,7 @@ void PolyModule :: choose_interpretations() {
           args.push_back(new Polvar(varname[combis[m][p]]));
         intp->add_child(new Product(b, new Functional(varname[k], args)));
         definitelynotfiltered->add_child(b->copy());
+        used.push_back(b->query_index());
         // c * x1 * ... * xn * F(x1,...,xn)
         for (p = 0; p < args.size(); p++) args[p] = args[p]->copy();
         Functional *func = new Functional(varname[k], args);
@@ -358,6 +675,7 @@ void PolyModule :: choose_interpretations() {
         int geq1 = constraints.add_geq(
           definitelynotfiltered->simplify(), new Integer(1));
         constraints.add_formula(new Var(geq1));
+        essential_unknowns.push_back(used);
       }
     }
 
@@ -376,6 +694,7 @@ void PolyModule :: choose_interpretations() {
       }
 
       Unknown *a = new_unknown();
+      simple_ones.push_back(a->query_index());
       Functional *func = new Functional(varname[k], args);
       intp->add_child(new Product(a, func));
       if (problem->unfilterable(f) && k < arities[f])
@@ -388,6 +707,7 @@ void PolyModule :: choose_interpretations() {
       var_indexes.push_back(varname[j]);
     interpretations[f] =
       new PolynomialFunction(var_indexes, vartypes, intp->simplify());
+    symbol_unknowns[f].second = minimum.size();
   }
 
   /* // for debugging purposes!
@@ -409,11 +729,20 @@ void PolyModule :: choose_interpretations() {
       columns.push_back(wout.print_polynomial_function(
         interpretations[symbol], freename, boundname));
       wout.table_entry(columns);
+      parametric_rows.push_back(columns);
     }
     wout.end_table();
   }
 }
 
+void PolyModule :: print_rows(string header,
+                              vector< vector<string> > &rows) {
+  wout.print(header);
+  wout.start_table();
+  for (int i = 0; i < rows.size(); i++) wout.table_entry(rows[i]);
+  wout.end_table();
+}
+
 vector< vector<int> > PolyModule :: combinations(vector<int> &numbers,
                                                  int n) {
   vector< vector<int> > ret;
@@ -495,6 +824,7 @@ void PolyModule :: interpret_requirements() {
       entry.push_back(wout.polgeq_symbol());
       entry.push_back(wout.print_polynomial(r, freerename, boundrename));
       wout.table_entry(entry);
+      constraint_rows.push_back(entry);
     }
 
     // add into the constraints
@@ -522,6 +852,16 @@ void PolyModule :: interpret_requirements() {
 
 PolynomialFunction *PolyModule :: interpret(PTerm term,
                  map<int,PolynomialFunction*> &subst) {
+  // the same subterms occur in many requirements, so we remember
+  // their interpretations (as long as their free variables are known)
+  if (interpret_depth == 0) known_keys.clear();
+  map<int,string> bound;
+  string key;
+  bool cacheable = interpretation_key(term, subst, bound, key);
+  if (cacheable && interpretation_cache.find(key) !=
+                   interpretation_cache.end())
+    return rename_function(interpretation_cache[key]);
+
   PType type = term->query_type();
   vector<PolynomialFunction*> args;
   vector<int> varids;
@@ -539,10 +879,115 @@ PolynomialFunction *PolyModule :: interpret(PTerm term,
     type = type->query_child(1);
   }
 
+  interpret_depth++;
   PPol main = interpret(term, subst, args);
+  interpret_depth--;
+  PolynomialFunction *ret = new PolynomialFunction(varids, vartypes, main);
+  if (cacheable) interpretation_cache[key] = ret->copy();
+  return ret;
+}
+
+bool PolyModule :: interpretation_key(PTerm term,
+                                      map<int,PolynomialFunction*> &subst,
+                                      map<int,string> &bound,
+                                      string &key) {
+  // without bound variables above it, the key of a subterm does not
+  // depend on where it occurs
+  if (bound.empty() && known_keys.find(term) != known_keys.end()) {
+    key = known_keys[term];
+    return true;
+  }
+
+  bool ok = true;
+  string sub;
+
+  if (term->query_constant())
+    key = dynamic_cast<PConstant>(term)->query_name();
+
+  else if (term->query_variable()) {
+    int index = dynamic_cast<PVariable>(term)->query_index();
+    if (bound.find(index) != bound.end()) key = bound[index];
+    else if (subst.find(index) != subst.end())
+      key = "[" + subst[index]->to_string() + "]";
+    else ok = false;
+  }
+
+  else if (term->query_meta()) {
+    MetaApplication *ma = dynamic_cast<MetaApplication*>(term);
+    int index = ma->get_metavar()->query_index();
+    if (subst.find(index) == subst.end()) return false;
+    key = "[" + subst[index]->to_string() + "](";
+    for (int i = 0; i < ma->number_children() && ok; i++) {
+      ok = interpretation_key(ma->get_child(i), subst, bound, sub);
+      key += key_reference(sub) + ",";
+    }
+    key += ")";
+  }
+
+  else if (term->query_abstraction()) {
+    PVariable x =
+      dynamic_cast<Abstraction*>(term)->query_abstraction_variable();
+    int index = x->query_index();
+    bool shadows = bound.find(index) != bound.end();
+    string old = shadows ? bound[index] : "";
+    string name = "b" + wout.str(bound.size());
+    bound[index] = name;
+    ok = interpretation_key(term->get_child(0), subst, bound, sub);
+    if (shadows) bound[index] = old;
+    else bound.erase(index);
+    key = "/\\" + name + ":" + x->query_type()->to_string() + "." +
+          key_reference(sub);
+  }
+
+  else if (term->query_application()) {
+    string a, b;
+    ok = interpretation_key(term->get_child(0), subst, bound, a) &&
+         interpretation_key(term->get_child(1), subst, bound, b);
+    key = "(" + key_reference(a) + " " + key_reference(b) + ")";
+  }
+
+  else ok = false;
+
+  if (ok && bound.empty()) known_keys[term] = key;
+  return ok;
+}
+
+string PolyModule :: key_reference(string key) {
+  if (key_ids.find(key) == key_ids.end()) {
+    int id = key_ids.size();
+    key_ids[key] = id;
+  }
+  return "#" + wout.str(key_ids[key]);
+}
+
+PolynomialFunction *PolyModule :: rename_function(PolynomialFunction *f) {
+  vector<PolynomialFunction*> args;
+  vector<int> varids;
+  vector<PType> vartypes;
+
+  for (int i = 0; i < f->num_variables(); i++) {
+    int id = unused_polvar_index();
+    varids.push_back(id);
+    vartypes.push_back(f->variable_type(i)->copy());
+    args.push_back(make_variable(f->variable_type(i), id));
+  }
+
+  PPol main = f->apply(args);
+  for (int j = 0; j < args.size(); j++) delete args[j];
   return new PolynomialFunction(varids, vartypes, main);
 }
 
+void PolyModule :: clear_interpretation_cache() {
+  map<string,PolynomialFunction*>::iterator it;
+  for (it = interpretation_cache.begin(); it != interpretation_cache.end();
+       it++) {
+    delete it->second;
+  }
+  interpretation_cache.clear();
+  key_ids.clear();
+  known_keys.clear();
+}
+
 PPol PolyModule :: interpret(PTerm term, map<int,PolynomialFunction*>
                              &subst, vector<PolynomialFunction*> &args) {
   int i;
@@ -596,6 +1041,8 @@ PPol PolyModule :: interpret(PTerm term, map<int,PolynomialFunction*>
     ret = interpret(term->get_child(0), subst, remaining);
     delete subst[varindex];
     subst.erase(varindex);
+    // the keys of subterms of the body may refer to the variable
+    known_keys.clear();
   }
 
   // application => turn further arguments into args, and use + or
@@ -660,6 +1107,9 @@ vector<int> PolyModule :: get_solution() {
     substitution[i] = new Integer(minimum[i]);
   }
 
+  // the interpretations are about to change
+  clear_interpretation_cache();
+
   problem->justify_orientables();
   bool formal_print = problem->strictly_oriented().size() > 0;
 
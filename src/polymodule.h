@@ -27,11 +27,17 @@
 #define MAX_SPECIAL_UNKNOWN 7
 
 typedef map<string,int> ArList;
+typedef map<string, vector<int> > PolyModel;
+  // the values of the unknowns in the interpretation of each symbol,
+  // in the order in which they are created
 
 class PolyModule {
   private:
     OrderingProblem *problem;
     bool do_base_products;
+    bool delay_products;
+    bool encoded;
+      // set once the constraints for the requirements have been built
     ArList arities;
 
     void comment(string txt);
@@ -41,7 +47,41 @@ class PolyModule {
     vector<int> minimum, maximum;
       // has lower and upper bounds for all unknowns
     PolConstraintList constraints;
-
+    map<string, pair<int,int> > symbol_unknowns;
+      // the unknowns in the interpretation of f range from
+      // symbol_unknowns[f].first to symbol_unknowns[f].second - 1
+    map<string,PolynomialFunction*> interpretation_cache;
+      // interpretations of subterms, indexed by interpretation_key
+    map<string,int> key_ids;
+      // numbers for the keys of subterms, so the key of a term can
+      // refer to its children by number rather than by their keys
+    map<PTerm,string> known_keys;
+      // the keys of the subterms of the term currently being
+      // interpreted, so they are not computed again for each subterm
+    int interpret_depth;
+      // the nesting of interpret calls, so known_keys is only used
+      // within a single term
+    PolyModel candidate;
+    PolyModel model;
+    vector<int> product_unknowns;
+      // the coefficients of the products of base type arguments
+    vector<int> simple_ones;
+    vector<int> simple_constants;
+      // the unknowns which are 1 or the constant in the simple
+      // interpretations; all other unknowns are 0 there
+    vector< vector<int> > essential_unknowns;
+      // for every functional argument which may not be filtered away,
+      // the unknowns of which at least one must be positive
+    vector< vector<string> > parametric_rows, constraint_rows;
+      // the tables of parametric interpretations and constraints
+      // printed in verbose mode, so enable_products can repeat them
+
+    bool solve_constraints();
+      // solves the generated constraints, and if this succeeds sets
+      // minimum to the values of the unknowns
+    vector<int> finish(bool success);
+      // prints the solution if there is one, and returns the data for
+      // the strictly oriented requirements (empty if !success)
     bool monomorphic();
     void choose_interpretations();
       // chooses interpretations \x1...xn.p for all symbols in the
@@ -59,12 +99,61 @@ class PolyModule {
              PolynomialFunction *&l, PolynomialFunction *&r,
              map<int,int> &metarename);
     void interpret_requirements();
+    void print_rows(string header, vector< vector<string> > &rows);
+      // prints header followed by a table with the given rows
     PolynomialFunction *interpret(PTerm term,
                            map<int,PolynomialFunction*> &subst);
     PPol interpret(PTerm term, map<int,PolynomialFunction*> &subst,
                    vector<PolynomialFunction*> &args);
+    bool interpretation_key(PTerm term,
+                            map<int,PolynomialFunction*> &subst,
+                            map<int,string> &bound, string &key);
+      // sets key to a description of term which determines its
+      // interpretation under subst (bound names the variables bound
+      // above term); returns false if term has a free variable which
+      // does not occur in subst yet
+    string key_reference(string key);
+      // returns a short name for key, to be used in the keys of
+      // terms which have the corresponding term as a child
+    PolynomialFunction *rename_function(PolynomialFunction *f);
+      // returns a copy of f which uses fresh variable indexes
+    void clear_interpretation_cache();
+      // frees the remembered interpretations of subterms
     PolynomialFunction *make_nul(PType type);
 
+    vector<int> candidate_hints();
+      // returns the value suggested by the candidate model for every
+      // unknown, or -1 if there is none
+    bool check_candidate(vector<int> &hints);
+      // tries the interpretation given by the hints (and the minimum
+      // for unknowns without one) without building constraints or
+      // calling the solver, as simple_interpretation does
+    vector<Valuation> save_valuation();
+    void restore_valuation(vector<Valuation> &saved);
+      // store and restore the valuation of all variables, removing
+      // variables created in between
+    bool simple_interpretation();
+      // tries the simple interpretations for constants 0 and 1
+      // without calling the solver; if one of them orients the
+      // requirements, minimum is set to it and the valuation to the
+      // corresponding choices
+    bool simple_interpretation(int constant);
+      // helping function for simple_interpretation
+    bool try_values(vector<int> &values);
+      // checks whether the interpretation with the given values for
+      // the unknowns orients the requirements; if so, minimum is set
+      // to it and the valuation to the corresponding choices
+    bool force_simple(int var, bool value);
+      // sets var to value if it is unknown, and returns whether it
+      // has that value
+    bool simple_monomials(PPol pol, map<string,int> &coefs);
+      // adds the coefficients of the monomials in the simplified,
+      // unknown-free pol to coefs (the constant part is stored under
+      // ""); returns false if pol has an unexpected form
+    int simple_compare(PPol left, PPol right);
+      // returns 2 if left > right certainly holds for all values of
+      // the variables, 1 if left >= right certainly does, and 0 if
+      // neither is obvious
     vector<int> get_solution();
       // assuming all unknowns are known, or can be set to anything
       // in their range, returns which dependency pairs have been
@@ -87,16 +176,35 @@ class PolyModule {
     ~PolyModule();
   
     void set_use_products(bool value);
+    void set_delay_products(bool value);
+      // if set, orient creates the product monomials but fixes their
+      // coefficients to 0; if it fails, enable_products can then try
+      // again with products, without rebuilding the constraints
+    vector<int> enable_products();
+      // after orient has failed with delayed products, solves the same
+      // constraints with the product coefficients unrestricted; returns
+      // the strictly oriented requirements, as orient does
     vector<int> orient(OrderingProblem *prob);
       // orients the given ordering requirements using a polynomial
       // interpretation returns the data for the ones which have been
       // strictly oriented
+    void set_candidate(PolyModel &model);
+      // suggests an interpretation to try first, such as the one
+      // found for a similar problem; if it does not orient the
+      // requirements, its values are still preferred in the search
+    PolyModel query_model();
+      // after orient has succeeded, returns the interpretation which
+      // was found, in a form which can be given to set_candidate
 
     PolynomialFunction *make_variable(PType type, int id);
       // helping function which is also used in PolConstraintList
     Unknown *new_unknown(int maximum = MAX_UNKNOWN);
       // creates a new unknown which ranges from 0-maximum
       // (also a helping function used in PolConstraintList)
+    int upper_bound(PPol pol);
+      // returns the largest value pol can take, given the ranges of
+      // the unknowns it contains, or -1 if pol contains anything other
+      // than integers, unknowns, sums and products
 };
 
 #endif
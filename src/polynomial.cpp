@@ -15,6 +15,8 @@
  *************************************************************************/
 
 #include "polynomial.h"
+#include <algorithm>
+#include <climits>
 #include <cstdio>
 #include <iostream>
 
@@ -32,16 +34,13 @@ int Polynomial :: cmp(int a, int b) {
   return 0;
 }
 
+// strict ordering used by Polynomial::sort
+struct PolynomialLess {
+  bool operator()(PPol a, PPol b) const { return a->compare(b) < 0; }
+};
+
 void Polynomial :: sort(vector<PPol> &vec) {
-  for (int i = 0; i+1 < vec.size(); i++) {
-    for (int j = i+1; j < vec.size(); j++) {
-      if (vec[i]->compare(vec[j]) == 1) {
-        PPol tmp = vec[j];
-        vec[j] = vec[i];
-        vec[i] = tmp;
-      }
-    }
-  }
+  stable_sort(vec.begin(), vec.end(), PolynomialLess());
 }
 
 string Polynomial :: to_string(bool brackets) {
@@ -637,32 +636,7 @@ PPol Sum :: simplify() {
   }
 
   // merge similar products, so i*a + j*a with i, j integers
-  bool changed = true, anychanges = false;
-  while (changed) {
-    changed = false;
-    for (i = 0; i < parts.size(); i++) {
-      for (int j = i+1; j < parts.size(); j++) {
-        int a, b;
-        if (parts[i]->query_similar(parts[j], a, b)) {
-          int c = a+b;
-          if (a == 1) parts[i] = new Product(new Integer(c), parts[i]);
-          else {
-            Product *p = dynamic_cast<Product*>(parts[i]);
-            dynamic_cast<Integer*>(p->get_child(0))->set_value(c);
-          }
-          delete parts[j];
-          parts[j] = parts[parts.size()-1];
-          parts.pop_back();
-          j--;
-          changed = true;
-        }
-      }
-    }
-    anychanges |= changed;
-  }
-
-  // changes might have caused the order to be messed up
-  if (anychanges) sort(parts);
+  if (merge_monomials()) sort(parts);
 
   if (parts.size() == 0) {
     delete this;
@@ -678,6 +652,88 @@ PPol Sum :: simplify() {
   return this;
 }
 
+/* splits a simplified term into its integer coefficient and the
+ * remaining factors (which are not copied) */
+static int split_monomial(PPol term, vector<PPol> &factors) {
+  if (!term->query_product()) {
+    factors.push_back(term);
+    return 1;
+  }
+  int start = 0, coef = 1;
+  if (term->number_children() > 0 && term->get_child(0)->query_integer()) {
+    coef = dynamic_cast<Integer*>(term->get_child(0))->query_value();
+    start = 1;
+  }
+  for (int i = start; i < term->number_children(); i++)
+    factors.push_back(term->get_child(i));
+  return coef;
+}
+
+// orders terms by their monomial, ignoring the coefficient
+struct MonomialLess {
+  bool operator()(const pair<vector<PPol>,int> &a,
+                  const pair<vector<PPol>,int> &b) const {
+    if (a.first.size() != b.first.size())
+      return a.first.size() < b.first.size();
+    for (int i = 0; i < a.first.size(); i++) {
+      int c = a.first[i]->compare(b.first[i]);
+      if (c != 0) return c < 0;
+    }
+    return false;
+  }
+};
+
+bool Sum :: merge_monomials() {
+  int i, j;
+
+  // pair every term with its monomial, and sort on the monomials, so
+  // terms i*m and j*m end up next to each other
+  vector< pair<vector<PPol>,int> > monomials(parts.size());
+  vector<int> coefs(parts.size());
+  for (i = 0; i < parts.size(); i++) {
+    coefs[i] = split_monomial(parts[i], monomials[i].first);
+    monomials[i].second = i;
+  }
+  MonomialLess less;
+  stable_sort(monomials.begin(), monomials.end(), less);
+
+  bool changed = false;
+  vector<PPol> newparts;
+  for (i = 0; i < monomials.size(); i = j) {
+    int first = monomials[i].second;
+    int total = coefs[first];
+    for (j = i+1; j < monomials.size() &&
+                  !less(monomials[i], monomials[j]); j++) {
+      total += coefs[monomials[j].second];
+      delete parts[monomials[j].second];
+      changed = true;
+    }
+    PPol term = parts[first];
+    if (total == coefs[first]) { newparts.push_back(term); continue; }
+    if (total == 0) { delete term; continue; }
+
+    // rebuild the term with the combined coefficient
+    vector<PPol> factors;
+    if (total != 1) factors.push_back(new Integer(total));
+    if (term->query_product()) {
+      Product *prod = dynamic_cast<Product*>(term);
+      if (coefs[first] != 1 || prod->get_child(0)->query_integer())
+        delete prod->get_child(0);
+      else factors.push_back(prod->get_child(0));
+      for (int k = 1; k < prod->number_children(); k++)
+        factors.push_back(prod->get_child(k));
+      prod->flat_free();
+    }
+    else factors.push_back(term);
+    if (factors.size() == 1) newparts.push_back(factors[0]);
+    else newparts.push_back(new Product(factors));
+  }
+
+  // the order of the terms is only touched if something was merged
+  if (changed) parts = newparts;
+  return changed;
+}
+
 PPol Sum :: replace_unknowns(map<int,PPol> &substitution) {
   for (int i = 0; i < parts.size(); i++)
     parts[i] = parts[i]->replace_unknowns(substitution);
@@ -932,6 +988,19 @@ PPol Product :: simplify() {
     return new Integer(0);
   }
 
+  // sums without functionals or maxes are multiplied out in the
+  // sparse representation
+  bool sparse = false;
+  for (i = 0; i < parts.size() && !sparse; i++)
+    sparse = parts[i]->query_sum();
+  for (i = 0; i < parts.size() && sparse; i++)
+    sparse = SparsePolynomial::convertible(parts[i]);
+  if (sparse) {
+    SparsePolynomial result(this);
+    delete this;
+    return result.to_polynomial();
+  }
+
   // deal with sums
   PPol tmp = sum_children();
   if (tmp != this) return tmp->simplify();
@@ -1012,6 +1081,180 @@ void Product :: vars(vector<Polvar*> initial) {
     parts[i]->vars(initial);
 }
 
+SparsePolynomial :: SparsePolynomial(PPol pol) {
+  Monomial monomial;
+  int coef = 1;
+  if (read_monomial(pol, monomial, coef)) {
+    if (coef != 0) terms.push_back(make_pair(monomial, coef));
+    return;
+  }
+
+  if (pol->query_sum()) {
+    for (int i = 0; i < pol->number_children(); i++) {
+      SparsePolynomial part(pol->get_child(i));
+      terms.insert(terms.end(), part.terms.begin(), part.terms.end());
+    }
+    normalise();
+    return;
+  }
+
+  // a product with sums among its factors
+  terms.push_back(make_pair(Monomial(), 1));
+  for (int i = 0; i < pol->number_children(); i++) {
+    SparsePolynomial part(pol->get_child(i));
+    multiply(part);
+  }
+}
+
+bool SparsePolynomial :: convertible(PPol pol) {
+  if (pol->query_integer() || pol->query_unknown() ||
+      pol->query_variable()) return true;
+  if (!pol->query_sum() && !pol->query_product()) return false;
+  for (int i = 0; i < pol->number_children(); i++)
+    if (!convertible(pol->get_child(i))) return false;
+  return true;
+}
+
+bool SparsePolynomial :: read_monomial(PPol pol, Monomial &monomial,
+                                       int &coef) {
+  if (pol->query_integer())
+    coef *= dynamic_cast<Integer*>(pol)->query_value();
+  else if (pol->query_unknown())
+    add_atom(monomial, 2 * dynamic_cast<Unknown*>(pol)->query_index());
+  else if (pol->query_variable())
+    add_atom(monomial, 2 * dynamic_cast<Polvar*>(pol)->query_index() + 1);
+  else if (pol->query_product()) {
+    for (int i = 0; i < pol->number_children(); i++)
+      if (!read_monomial(pol->get_child(i), monomial, coef)) return false;
+  }
+  else return false;
+  return true;
+}
+
+string SparsePolynomial :: code_bytes(int code) {
+  char bytes[4] = { (char)(code >> 24), (char)(code >> 16),
+                    (char)(code >> 8), (char)code };
+  return string(bytes, 4);
+}
+
+void SparsePolynomial :: add_atom(Monomial &monomial, int code) {
+  int pos = 0;
+  while (pos < monomial.size() && atom(monomial, pos) <= code) pos += 4;
+  monomial.insert(pos, code_bytes(code));
+}
+
+int SparsePolynomial :: atom(const Monomial &monomial, int pos) {
+  return ((unsigned char)monomial[pos] << 24) |
+         ((unsigned char)monomial[pos+1] << 16) |
+         ((unsigned char)monomial[pos+2] << 8) |
+         (unsigned char)monomial[pos+3];
+}
+
+SparsePolynomial::Monomial SparsePolynomial :: times(const Monomial &a,
+                                                     const Monomial &b) {
+  if (a.empty()) return b;
+  if (b.empty()) return a;
+  Monomial ret;
+  ret.reserve(a.size() + b.size());
+  int i = 0, j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (atom(a, i) <= atom(b, j)) { ret.append(a, i, 4); i += 4; }
+    else { ret.append(b, j, 4); j += 4; }
+  }
+  ret.append(a, i, string::npos);
+  ret.append(b, j, string::npos);
+  return ret;
+}
+
+void SparsePolynomial :: normalise() {
+  std::sort(terms.begin(), terms.end());
+  int j = 0;
+  for (int i = 0; i < terms.size(); i++) {
+    if (j > 0 && terms[j-1].first == terms[i].first)
+      terms[j-1].second += terms[i].second;
+    else {
+      if (j > 0 && terms[j-1].second == 0) j--;
+      if (i != j) terms[j].swap(terms[i]);
+      j++;
+    }
+  }
+  if (j > 0 && terms[j-1].second == 0) j--;
+  terms.resize(j);
+}
+
+void SparsePolynomial :: multiply(SparsePolynomial &other) {
+  vector< pair<Monomial,int> > product;
+  product.reserve(terms.size() * other.terms.size());
+  for (int i = 0; i < terms.size(); i++) {
+    for (int j = 0; j < other.terms.size(); j++) {
+      product.push_back(make_pair(
+        times(terms[i].first, other.terms[j].first),
+        terms[i].second * other.terms[j].second));
+    }
+  }
+  terms.swap(product);
+  normalise();
+}
+
+string SparsePolynomial :: term_key(const Monomial &monomial, int coef) {
+  // every part is given by its query_type() and its value or index;
+  // flipping the sign bit makes negative values sort first
+  string ret;
+  ret.reserve(monomial.size() / 4 * 5 + 6);
+  int j;
+  if (coef != 1 || monomial.empty())
+    ret.append(1, (char)0).append(code_bytes(coef ^ INT_MIN));
+  for (j = 0; j < monomial.size(); j += 4) {
+    if (monomial[j+3] & 1) continue;
+    ret.append(1, (char)2).append(code_bytes(atom(monomial, j) / 2));
+  }
+  for (j = 0; j < monomial.size(); j += 4) {
+    if (!(monomial[j+3] & 1)) continue;
+    ret.append(1, (char)4).append(code_bytes(atom(monomial, j) / 2));
+  }
+  // a single part stands for itself, while a product has the type
+  // just above that of its last part
+  if (ret.size() == 5) return ret;
+  return ret.insert(0, 1, (char)(ret[ret.size()-5] + 1));
+}
+
+PPol SparsePolynomial :: to_polynomial() {
+  // put the terms in the order Sum::simplify would give them
+  vector< pair<string,int> > order;
+  order.reserve(terms.size());
+  int i, j;
+  for (i = 0; i < terms.size(); i++)
+    order.push_back(make_pair(term_key(terms[i].first, terms[i].second), i));
+  std::sort(order.begin(), order.end());
+
+  vector<PPol> parts;
+  parts.reserve(order.size());
+  for (i = 0; i < order.size(); i++) {
+    Monomial &monomial = terms[order[i].second].first;
+    int coef = terms[order[i].second].second;
+
+    // the factors in the order Product::simplify gives them: the
+    // coefficient, the unknowns and then the variables
+    vector<PPol> factors;
+    factors.reserve(monomial.size() / 4 + 1);
+    if (coef != 1 || monomial.empty()) factors.push_back(new Integer(coef));
+    for (j = 0; j < monomial.size(); j += 4) {
+      int code = atom(monomial, j);
+      if (code % 2 == 0) factors.push_back(new Unknown(code / 2));
+    }
+    for (j = 0; j < monomial.size(); j += 4) {
+      int code = atom(monomial, j);
+      if (code % 2 == 1) factors.push_back(new Polvar(code / 2));
+    }
+    if (factors.size() == 1) parts.push_back(factors[0]);
+    else parts.push_back(new Product(factors));
+  }
+
+  if (parts.size() == 0) return new Integer(0);
+  if (parts.size() == 1) return parts[0];
+  return new Sum(parts);
+}
+
 PolynomialFunction :: PolynomialFunction(vector<int> vars,
                                          vector<PType> types,
                                          PPol main) {
@@ -39,8 +39,7 @@ class Polynomial {
       // a > b and 0 if they are equal
 
     void sort(vector<PPol> &vec);
-      // sorts the given vector, using bubblesort and the compare
-      // function
+      // sorts the given vector, using the compare function
 
   public: // but for internal use only!
 
@@ -227,6 +226,12 @@ class Sum : public Polynomial {
   private:
     vector<PPol> parts;
 
+    bool merge_monomials();
+      // helping function for simplify: combines the terms i*m and
+      // j*m with the same monomial m into (i+j)*m, by sorting the
+      // terms on their monomial rather than comparing all pairs;
+      // returns whether anything changed
+
   public:
     Sum();
     Sum(PPol part);
@@ -293,6 +298,55 @@ class Product : public Polynomial {
     void vars(vector<Polvar*> initial);
 };
 
+/**
+ * A polynomial without functionals or maxes in canonical form: its
+ * monomials with their (non-zero) coefficients, sorted on the monomial
+ * and without duplicates.  A monomial is a sorted list of atoms, where
+ * the unknown a_i has code 2*i and the variable x_i has code 2*i+1; an
+ * atom occurring k times stands for its k-th power, and the empty
+ * monomial holds the constant.  The codes are stored as four bytes
+ * each, most significant first, so monomials compare as strings.
+ * Product::simplify uses this to multiply out sums and add up the
+ * resulting like terms, without building and comparing all the
+ * intermediate terms.
+ */
+class SparsePolynomial {
+  private:
+    typedef string Monomial;
+    vector< pair<Monomial,int> > terms;
+
+    static bool read_monomial(PPol pol, Monomial &monomial, int &coef);
+      // if pol is a product of integers, unknowns and variables, adds
+      // its atoms to monomial, multiplies coef by its integer part and
+      // returns true; otherwise returns false
+    static string code_bytes(int code);
+      // returns the four bytes which store code in a monomial
+    static void add_atom(Monomial &monomial, int code);
+      // inserts the given atom into the sorted monomial
+    static int atom(const Monomial &monomial, int pos);
+      // returns the code of the atom starting at position pos
+    static Monomial times(const Monomial &a, const Monomial &b);
+      // returns the monomial a*b
+    void normalise();
+      // sorts the terms and merges those with the same monomial
+    static string term_key(const Monomial &monomial, int coef);
+      // returns a string which orders the terms of a sum as compare
+      // orders the polynomials that to_polynomial builds for them
+
+  public:
+    SparsePolynomial(PPol pol);
+      // pol must be convertible; it is not altered or consumed, and
+      // like terms of sums in it are added up
+
+    static bool convertible(PPol pol);
+      // returns whether pol is built from integers, unknowns and
+      // variables using only sums and products
+
+    void multiply(SparsePolynomial &other);
+    PPol to_polynomial();
+      // returns the corresponding simplified polynomial
+};
+
 class PolynomialFunction {
   private:
     vector<int> variables;
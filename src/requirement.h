@@ -36,13 +36,14 @@ class OrderRequirement {
 
   private:
     bool strong;
+    bool dropped;
     unsigned int condition;
     vector<int> data;
       // indexes of rules / dependency pairs corresponding to this
       // ordering requirement
 
     OrderRequirement(PTerm l, PTerm r, bool s, unsigned int c)
-      :left(l), right(r), strong(s), condition(c) {}
+      :left(l), right(r), strong(s), dropped(false), condition(c) {}
 
   public:
     /* creates the requirement: True => l >= r */
@@ -92,6 +93,16 @@ class OrderRequirement {
       return c;
     }
 
+    /* removes this requirement from the problem it is part of: it
+    no longer needs to be oriented at all; returns the old condition */
+    unsigned int drop() {
+      dropped = true;
+      return update_condition(vars.false_var());
+    }
+
+    /* returns true if drop() has been called */
+    bool query_dropped() { return dropped; }
+
     /* returns a formula indicating that left > right is necessary */
     PFormula orient_greater() {
       if (strong) return new Var(condition);
@@ -36,7 +36,13 @@ bool RuleRemover :: remove_all(Alphabet &F, Ruleset &R) {
   wout.print("We use a reduction pair to orient all rules at once.  "
     "This is an instance of rule removal, following " +
     wout.cite("Kop12", "Theorem 2.23") + ", with empty set R3.");
-  if (attempt_rule_removal(F, R, true)) {
+  vars.reset();
+  PlainOrderingProblem *prob =
+    new PlainOrderingProblem(R, F, use_arities, true);
+  bool success = attempt_rule_removal(prob, F, R, true);
+  delete prob;
+  remove_null(R);
+  if (success) {
     wout.succeed_method("reduction pair");
     wout.print("As all rules were successfully removed, termination "
       "of the original system has been reduced to termination of the "
@@ -49,22 +55,39 @@ bool RuleRemover :: remove_all(Alphabet &F, Ruleset &R) {
 
 bool RuleRemover :: remove_rules(Alphabet &F, Ruleset &R) {
   bool removed_something = false;
+  int i, remaining = R.size();
 
   wout.verbose_print("Doing rule removal...\n");
 
+  // the ordering problem is built once, and reused in every round
+  // with the requirements of the removed rules dropped
+  vars.reset();
+  PlainOrderingProblem *prob =
+    new PlainOrderingProblem(R, F, use_arities, false);
+  int problem_vars = vars.query_size();
+  vector<bool> dropped(R.size(), false);
+
   while (true) {
     wout.start_method("rule removal");
     wout.print("We use rule removal, following " +
       wout.cite("Kop12", "Theorem 2.23") + ".\n");
-    if (attempt_rule_removal(F, R, false)) {
+    vars.truncate(problem_vars);
+    if (attempt_rule_removal(prob, F, R, false)) {
       removed_something = true;
       wout.succeed_method("rule removal");
+      for (i = 0; i < R.size(); i++) {
+        if (R[i] == NULL && !dropped[i]) {
+          prob->drop_rule(i);
+          dropped[i] = true;
+          remaining--;
+        }
+      }
     }
     else {
       wout.abort_method("rule removal");
       break;
     }
-    if (R.empty()) {
+    if (remaining == 0) {
       if (removed_something)
         wout.print("All rules were succesfully removed.  Thus, "
           "termination of the original system has been reduced to "
@@ -73,16 +96,14 @@ bool RuleRemover :: remove_rules(Alphabet &F, Ruleset &R) {
       break;
     }
   }
+  delete prob;
+  remove_null(R);
   return removed_something;
 }
 
-bool RuleRemover :: attempt_rule_removal(Alphabet &F, Ruleset &R,
+bool RuleRemover :: attempt_rule_removal(OrderingProblem *prob,
+                                         Alphabet &F, Ruleset &R,
                                          bool all_at_once) {
-  // make an ordering problem to send into the horpo module
-  vars.reset();
-  OrderingProblem *prob = new PlainOrderingProblem(R, F, use_arities,
-                                                   all_at_once);
-
   wout.print("This gives the following requirements (possibly using "
     "Theorems 2.25 and 2.26 in " + wout.cite("Kop12") + "):\n");
   prob->print();
@@ -105,7 +126,6 @@ bool RuleRemover :: attempt_rule_removal(Alphabet &F, Ruleset &R,
     return true;
 
   wout.print("about to return\n");
-  delete prob;
 
   // nothing worked :(
   return false;
@@ -121,10 +141,12 @@ bool RuleRemover :: poly_handle(OrderingProblem *prob, Alphabet &F,
 
   // use the poly-tool!
   pols.set_use_products(products);
+  pols.set_candidate(last_model);
   vector<int> ok = pols.orient(prob);
   map<string,int> arities = prob->arities;
   
   if (ok.size() != 0) {
+    last_model = pols.query_model();
     if (indicate_removal) {
       wout.print("We can thus remove the following rules:\n");
     }
@@ -144,11 +166,6 @@ bool RuleRemover :: poly_handle(OrderingProblem *prob, Alphabet &F,
     }
     for (j = 0; j < Rok.size(); j++) delete Rok[j];
     wout.print("\n");
-    Ruleset Rmod;
-    for (int k = 0; k < R.size(); k++) {
-      if (R[k] != NULL) Rmod.push_back(R[k]);
-    }
-    R = Rmod;
     wout.succeed_method("poly attempt");
     return true;
   }
@@ -183,11 +200,6 @@ bool RuleRemover :: horpo_handle(OrderingProblem *prob, Alphabet &F,
     if (indicate_removal) wout.print_rules(Rok, F, arities);
     for (j = 0; j < Rok.size(); j++) delete Rok[j];
     wout.print("\n");
-    Ruleset Rmod;
-    for (int k = 0; k < R.size(); k++) {
-      if (R[k] != NULL) Rmod.push_back(R[k]);
-    }
-    R = Rmod;
     wout.succeed_method("horpo attempt");
     return true;
   }
@@ -196,3 +208,11 @@ bool RuleRemover :: horpo_handle(OrderingProblem *prob, Alphabet &F,
   return false;
 }
 
+void RuleRemover :: remove_null(Ruleset &R) {
+  Ruleset Rmod;
+  for (int k = 0; k < R.size(); k++) {
+    if (R[k] != NULL) Rmod.push_back(R[k]);
+  }
+  R = Rmod;
+}
+
@@ -17,6 +17,7 @@
 #include "alphabet.h"
 #include "matchrule.h"
 #include "orderingproblem.h"
+#include "polymodule.h"
 
 typedef vector<MatchRule*> Ruleset;
 
@@ -33,12 +34,19 @@ class RuleRemover {
     bool use_horpo;
     bool use_arities;
     bool formal_output;
+    PolyModel last_model;
+      // the interpretation found in the last successful round with
+      // polynomials, which is tried first in the next round
 
-    bool attempt_rule_removal(Alphabet &F, Ruleset &R,
-                              bool all_at_once);
+    bool attempt_rule_removal(OrderingProblem *problem, Alphabet &F,
+                              Ruleset &R, bool all_at_once);
       // main functionality: tries to remove one or more rules from
       // the given set, and returns true if this was succesful; if
-      // all_at_once is set, then all rules must be oriented in one go
+      // all_at_once is set, then all rules must be oriented in one go;
+      // removed rules are replaced by NULL in R, which is indexed in
+      // the same way as the rules the problem was created with
+    void remove_null(Ruleset &R);
+      // removes all NULL entries from R
     bool poly_handle(OrderingProblem *problem, Alphabet &F,
                      Ruleset &rules, bool products,
                      bool indicate_removal);
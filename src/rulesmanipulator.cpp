@@ -887,7 +887,8 @@ bool RulesManipulator :: symbol_occurs(SymbolList &list, string f,
 }
 
 SymbolList RulesManipulator :: formative_symbols(DPSet &DP,
-                                                 Ruleset &rules) {
+                                                 Ruleset &rules,
+                                                 vector<bool> &candidates) {
   SymbolList list;
 
   // initialisation: put in all left-hand sides of pairs in DP
@@ -902,6 +903,7 @@ SymbolList RulesManipulator :: formative_symbols(DPSet &DP,
     changed = false;
 
     for (int i = 0; i < rules.size(); i++) {
+      if (!candidates[i]) continue;
       PTerm l = rules[i]->query_left_side();
       PTerm r = rules[i]->query_right_side();
 
@@ -942,10 +944,12 @@ SymbolList RulesManipulator :: formative_symbols(DPSet &DP,
 }
 
 Ruleset RulesManipulator :: formative_rules_for(SymbolList &list,
-                                                Ruleset &rules) {
+                                                Ruleset &rules,
+                                                vector<bool> &candidates) {
   Ruleset ret;
 
   for (int i = 0; i < rules.size(); i++) {
+    if (!candidates[i]) continue;
     PTerm r = rules[i]->query_right_side();
 
     if (r->query_abstraction()) {
@@ -1009,8 +1013,59 @@ Ruleset RulesManipulator :: copy_rules(Ruleset &rules) {
   return ret;
 }
 
-Ruleset RulesManipulator :: formative_rules(DPSet DP, Ruleset rules) {
-  SymbolList list = formative_symbols(DP, rules);
+vector<bool> RulesManipulator :: formative_candidates(DPSet &DP,
+                                               SymbolDependencies &deps) {
+  vector<bool> found(deps.index.size(), false);
+  vector<bool> candidates(deps.rhs_head.size(), false);
+  bool any = false;
+  int i, j;
+
+  // the symbols below the left-hand sides of the pairs are formative
+  for (i = 0; i < DP.size(); i++) {
+    PTerm l = DP[i]->query_left();
+    for (; l->query_application(); l = l->subterm("1")) {
+      vector<string> symbols;
+      vector<PType> types;
+      Symb(l->subterm("2"), symbols, types);
+      for (j = 0; j < symbols.size(); j++) {
+        any = true;
+        map<string,int>::iterator it = deps.index.find(symbols[j]);
+        if (it != deps.index.end()) found[it->second] = true;
+      }
+    }
+  }
+
+  // a rule may be formative if the head of its right-hand side is;
+  // rules with a variable or abstraction there may be formative if
+  // anything is
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (i = 0; i < candidates.size(); i++) {
+      if (candidates[i]) continue;
+      int head = deps.rhs_head[i];
+      if (head == -1 ? !any : !found[head]) continue;
+      candidates[i] = changed = any = true;
+      for (j = 0; j < deps.lhs_symbols[i].size(); j++)
+        found[deps.lhs_symbols[i][j]] = true;
+    }
+  }
+
+  return candidates;
+}
+
+Ruleset RulesManipulator :: formative_rules(DPSet DP, Ruleset rules,
+                                            SymbolDependencies *deps) {
+  SymbolDependencies own;
+  if (deps == NULL) {
+    symbol_dependencies(rules, own);
+    deps = &own;
+  }
+
+  // the typed calculation below only needs to consider rules which
+  // the untyped one does not exclude
+  vector<bool> candidates = formative_candidates(DP, *deps);
+  SymbolList list = formative_symbols(DP, rules, candidates);
   /* // for debugging
   cout << "=====" << endl << "Got symbols:" << endl;
   for (SymbolList::iterator it = list.begin(); it != list.end(); it++) {
@@ -1022,7 +1077,7 @@ Ruleset RulesManipulator :: formative_rules(DPSet DP, Ruleset rules) {
     cout << endl;
   }
   */
-  Ruleset ret = formative_rules_for(list, rules);
+  Ruleset ret = formative_rules_for(list, rules, candidates);
   free_list(list);
 
   // is everything properly linear and fully extended?
@@ -1041,6 +1096,82 @@ Ruleset RulesManipulator :: formative_rules(DPSet DP, Ruleset rules) {
 
 /* ========== usable rules ========== */
 
+static int symbol_number(map<string,int> &index, string symbol) {
+  map<string,int>::iterator it = index.find(symbol);
+  if (it != index.end()) return it->second;
+  int num = index.size();
+  index[symbol] = num;
+  return num;
+}
+
+void RulesManipulator :: symbol_dependencies(Ruleset &rules,
+                                             SymbolDependencies &deps) {
+  vector< vector<int> > successors;
+  int i, j;
+
+  for (i = 0; i < rules.size(); i++) {
+    PTerm l = rules[i]->query_left_side();
+    PTerm r = rules[i]->query_right_side();
+
+    // the symbols of the left-hand side
+    vector<string> symbols;
+    vector<PType> types;
+    Symb(l, symbols, types);
+    deps.lhs_symbols.push_back(vector<int>());
+    for (j = 0; j < symbols.size(); j++) {
+      deps.lhs_symbols[i].push_back(
+        symbol_number(deps.index, symbols[j]));
+    }
+
+    // the head of the right-hand side
+    PTerm rhead = r->query_head();
+    if (r->query_abstraction() || !rhead->query_constant())
+      deps.rhs_head.push_back(-1);
+    else {
+      deps.rhs_head.push_back(
+        symbol_number(deps.index, rhead->to_string(false)));
+    }
+
+    // all symbols in the right-hand side are successors of the head
+    // of the left-hand side
+    int f = symbol_number(deps.index,
+                          l->query_head()->to_string(false));
+    vector<int> found;
+    vector<PTerm> subs;
+    subs.push_back(r);
+    for (j = 0; j < subs.size(); j++) {
+      PTerm s = subs[j];
+      while (s->query_abstraction()) s = s->get_child(0);
+      for (int k = 0; k < s->number_children(); k++)
+        subs.push_back(s->get_child(k));
+      if (s->query_constant())
+        found.push_back(symbol_number(deps.index, s->to_string(false)));
+    }
+    if (successors.size() < deps.index.size())
+      successors.resize(deps.index.size());
+    successors[f].insert(successors[f].end(), found.begin(), found.end());
+  }
+
+  // close the successor relation by a search from every symbol
+  int n = deps.index.size();
+  successors.resize(n);
+  deps.reaches.resize(n, vector<bool>(n, false));
+  for (i = 0; i < n; i++) {
+    vector<int> todo(1, i);
+    deps.reaches[i][i] = true;
+    while (!todo.empty()) {
+      int g = todo.back();
+      todo.pop_back();
+      for (j = 0; j < successors[g].size(); j++) {
+        int h = successors[g][j];
+        if (deps.reaches[i][h]) continue;
+        deps.reaches[i][h] = true;
+        todo.push_back(h);
+      }
+    }
+  }
+}
+
 void RulesManipulator :: reachable_from(string symb, set<string>
                                         &found, Ruleset &rules) {
   found.insert(symb);
@@ -1107,11 +1238,17 @@ SymbolList RulesManipulator :: usable_symbols(DPSet &DP,
 }
 */
 
-Ruleset RulesManipulator :: usable_rules(DPSet DP, Ruleset rules) {
+Ruleset RulesManipulator :: usable_rules(DPSet DP, Ruleset rules,
+                                         SymbolDependencies *deps) {
   int i, j;
+  SymbolDependencies own;
+  if (deps == NULL) {
+    symbol_dependencies(rules, own);
+    deps = &own;
+  }
 
   // find usable symbols
-  set<string> symbols;
+  vector<bool> symbols(deps->index.size(), false);
   for (i = 0; i < DP.size(); i++) {
     vector<PTerm> split = DP[i]->query_right()->split();
     if (!split[0]->query_constant()) return rules;
@@ -1129,9 +1266,15 @@ Ruleset RulesManipulator :: usable_rules(DPSet DP, Ruleset rules) {
         subs.push_back(s->get_child(k));
 
       // for all symbols in the right-hand side, save the symbol and
-      // everything it reduces to as "usable"
-      if (s->query_constant())
-        reachable_from(s->to_string(false), symbols, rules);
+      // everything it reduces to as "usable"; symbols which do not
+      // occur in the rules do not make any rules usable
+      if (!s->query_constant()) continue;
+      map<string,int>::iterator it =
+        deps->index.find(s->to_string(false));
+      if (it == deps->index.end()) continue;
+      vector<bool> &reach = deps->reaches[it->second];
+      for (int k = 0; k < reach.size(); k++)
+        if (reach[k]) symbols[k] = true;
     }
   }
 
@@ -1139,7 +1282,7 @@ Ruleset RulesManipulator :: usable_rules(DPSet DP, Ruleset rules) {
   Ruleset ret;
   for (i = 0; i < rules.size(); i++) {
     string lhead = rules[i]->query_left_side()->query_head()->to_string(false);
-    if (symbols.find(lhead) == symbols.end()) continue;
+    if (!symbols[deps->index[lhead]]) continue;
       // only consider usable rules
     if (rules[i]->query_right_side()->query_abstraction())
       return rules;
@@ -33,6 +33,28 @@ typedef vector<MatchRule*> Ruleset;
 typedef vector<PType> TypeList;
 typedef map<string,TypeList> SymbolList;
 
+/**
+ * The connections between function symbols which a set of rules
+ * gives, ignoring types; this is calculated once for a ruleset, and
+ * reused to find the usable and formative rules for every set of
+ * dependency pairs which it is combined with.
+ */
+struct SymbolDependencies {
+  map<string,int> index;
+    // numbers the symbols occurring in the rules, including #ABS and
+    // #VAR as they are used for formative symbols
+  vector< vector<bool> > reaches;
+    // reaches[f][g] holds if a rule for f, or for a symbol which f
+    // reaches, has g in its right-hand side; reaches[f][f] always
+    // holds
+  vector<int> rhs_head;
+    // for every rule, the index of the head symbol of its right-hand
+    // side, or -1 if that side is an abstraction or has a variable as
+    // its head
+  vector< vector<int> > lhs_symbols;
+    // for every rule, the symbols which occur in its left-hand side
+};
+
 class RulesManipulator {
   private:
     bool query_linear(PTerm term, Varset &encountered);
@@ -52,8 +74,16 @@ class RulesManipulator {
                      vector<PType> &types);
     bool add_sub_symbols(SymbolList &list, PTerm l);
     bool symbol_occurs(SymbolList &list, string f, PType type);
-    SymbolList formative_symbols(DPSet &DP, Ruleset &rules);
-    Ruleset formative_rules_for(SymbolList &list, Ruleset &rules);
+    SymbolList formative_symbols(DPSet &DP, Ruleset &rules,
+                                 vector<bool> &candidates);
+    Ruleset formative_rules_for(SymbolList &list, Ruleset &rules,
+                                vector<bool> &candidates);
+      // only the rules i with candidates[i] set are considered; the
+      // others cannot be formative
+    vector<bool> formative_candidates(DPSet &DP,
+                                      SymbolDependencies &deps);
+      // returns for every rule whether it might be formative for DP,
+      // by an untyped closure of the symbols in DP's left-hand sides
     void free_list(SymbolList &list);
     void reachable_from(string symb, set<string> &found,
                         Ruleset &rules);
@@ -165,14 +195,19 @@ class RulesManipulator {
     Ruleset beta_saturate(Ruleset rules);
     Ruleset eta_expand(Ruleset rules);
       // note: this will destroy the original rules!
-    Ruleset formative_rules(DPSet DP, Ruleset rules);
+    void symbol_dependencies(Ruleset &rules, SymbolDependencies &deps);
+      // fills deps for the given rules
+    Ruleset formative_rules(DPSet DP, Ruleset rules,
+                            SymbolDependencies *deps = NULL);
       // note: the returned rules are (modified) copies of the given
-      // ones!
+      // ones!  If deps is given, it must belong to rules.
     Ruleset copy_rules(Ruleset &rules);
       // make a copy of the given set of rules
-    Ruleset usable_rules(DPSet DP, Ruleset rules);
+    Ruleset usable_rules(DPSet DP, Ruleset rules,
+                         SymbolDependencies *deps = NULL);
       // the returned rules are the same pointers as the given ones,
-      // just perhaps less of them
+      // just perhaps less of them; if deps is given, it must belong
+      // to rules
     bool simplify_applications(Alphabet &Sigma, Ruleset &rules);
       // notes when a given symbol is essentially an encoding for
       // application, and breaks it out if so; doing this may lose
@@ -15,6 +15,7 @@
  *************************************************************************/
 
 #include "sat.h"
+#include "parallel.h"
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
@@ -61,8 +62,12 @@ bool SatSolver :: solve(PFormula &formula) {
       if (vars.query_value(i) == FALSE) con->add_child(new AntiVar(i));
     }
     // generate a file with all restrictions in the SAT competition format
+    // (the files are private to this process, as several processes
+    // may be solving at the same time)
     int size = con->query_number_children();
-    FILE *fout = fopen("resources/input", "w");
+    string inputfile = WorkerPool::private_file("input");
+    string outputfile = WorkerPool::private_file("output");
+    FILE *fout = fopen(inputfile.c_str(), "w");
     fprintf(fout, "p cnf %d %d\n", vars.query_size(), size);
     for (int i = 0; i < size; i++) {
       PFormula child = con->query_child(i);
@@ -79,6 +84,7 @@ bool SatSolver :: solve(PFormula &formula) {
           if (!ch->query_variable() && !ch->query_antivariable()) {
             // illegal format
             fclose(fout);
+            remove(inputfile.c_str());
             return false;
           }
           int index;
@@ -96,6 +102,7 @@ bool SatSolver :: solve(PFormula &formula) {
       }
       else {
         fclose(fout);
+        remove(inputfile.c_str());
         return false;  // illegal format
       }
     }
@@ -104,10 +111,12 @@ bool SatSolver :: solve(PFormula &formula) {
 
     // now run minisat on the generated file
     // system("./resources/timeout 20 ./resources/satsolver resources/input resources/output > /dev/null");
-    system("./resources/timeout.sh 20 ./resources/satsolver resources/input resources/output > /dev/null");
+    system(("./resources/timeout.sh 20 ./resources/satsolver " + inputfile +
+            " " + outputfile + " > /dev/null").c_str());
+    remove(inputfile.c_str());
 
     // and read the results!
-    FILE *fin = fopen("resources/output", "r");
+    FILE *fin = fopen(outputfile.c_str(), "r");
     char check[10];
     if (fin == NULL) return false;
     fscanf(fin, "%s", check);
@@ -119,12 +128,12 @@ bool SatSolver :: solve(PFormula &formula) {
         else vars.force_value(var, TRUE);
       }
       fclose(fin);
-      system("rm resources/output");
+      remove(outputfile.c_str());
       return true;
     }
     else {
       fclose(fin);
-      system("rm resources/output");
+      remove(outputfile.c_str());
       return false;
     }
   }
@@ -16,6 +16,8 @@
 
 #include "smt.h"
 #include "bitblaster.h"
+#include "sat.h"
+#include <algorithm>
 #include <iostream>
 
 Smt :: Smt(vector<int> &mins, vector<int> &maxs) {
@@ -23,6 +25,10 @@ Smt :: Smt(vector<int> &mins, vector<int> &maxs) {
   maxima.insert(maxima.end(), maxs.begin(), maxs.end());
 }
 
+void Smt :: set_hints(vector<int> &h) {
+  hints = h;
+}
+
 bool Smt :: solve(PFormula formula, vector<int> &values) {
   check_minmax(formula);
 
@@ -37,10 +43,31 @@ bool Smt :: solve(PFormula formula, vector<int> &values) {
       changed = true;
       formula = simplify_formula(formula->simplify());
     }
+    if (!formula->query_conjunction()) break;
+    int bounds = propagate_bounds(dynamic_cast<And*>(formula));
+    if (bounds < 0) {
+      delete formula;
+      return false;
+    }
+    if (bounds > 0) {
+      changed = true;
+      check_minmax(formula);
+      formula = simplify_formula(decide_by_bounds(formula)->simplify());
+    }
   }
 
   save_squares(formula);
   save_unknown_products(formula);
+
+  // without products of unknowns, we can avoid bit-blasting
+  if (squares.empty() && unknown_products.empty()) {
+    LinearResult result = solve_linear(formula, values);
+    if (result != LINEAR_UNKNOWN) {
+      delete formula;
+      return result == LINEAR_SAT;
+    }
+  }
+
   save_known_products(formula);
   save_sums(formula);
   
@@ -61,6 +88,106 @@ bool Smt :: solve(PFormula formula, vector<int> &values) {
   return true;
 }
 
+/* ========== solving linear problems ========== */
+
+LinearResult Smt :: solve_linear(PFormula formula, vector<int> &values) {
+  LinearSolver solver(minima, maxima);
+  solver.set_hints(hints);
+  map<string,int> lookup;
+  vector<int> atomvars;
+
+  PFormula copy = formula->copy();
+  PFormula skeleton = abstract_arithmetic(copy, solver, lookup, atomvars);
+  if (skeleton == NULL) {
+    delete copy;
+    return LINEAR_UNKNOWN;
+  }
+  if (skeleton != copy) delete copy;
+  And *problem = new And(skeleton->simplify()->conjunctive_form());
+
+  // the variables the sat-solver is allowed to choose, so we can
+  // forget its choices after every round
+  vector<int> open;
+  for (int i = 0; i < vars.query_size(); i++) {
+    if (vars.query_value(i) == UNKNOWN) open.push_back(i);
+  }
+
+  SatSolver sat;
+  for (int round = 0; round < LINEAR_MAX_ROUNDS; round++) {
+    PFormula f = problem->copy();
+    if (!sat.solve(f)) {
+      delete f;
+      delete problem;
+      return LINEAR_UNSAT;
+    }
+    delete f;
+
+    vector<int> active;
+    for (int k = 0; k < atomvars.size(); k++) {
+      if (vars.query_value(atomvars[k]) == TRUE) active.push_back(k);
+    }
+    LinearResult result = solver.check(active, values);
+    if (result == LINEAR_SAT) {
+      delete problem;
+      return LINEAR_SAT;
+    }
+
+    for (int i = 0; i < open.size(); i++)
+      vars.force_value(open[i], UNKNOWN);
+    if (result == LINEAR_UNKNOWN) break;
+
+    // exclude this combination of inequalities in the next round; we
+    // look for a few different conflicts to save on sat calls
+    vector<int> dummy;
+    for (int n = 0; n < LINEAR_MAX_CONFLICTS && result == LINEAR_UNSAT;
+         n++) {
+      vector<int> core = solver.explain(active);
+      Or *block = new Or();
+      for (int j = 0; j < core.size(); j++)
+        block->add_child(new AntiVar(atomvars[core[j]]));
+      problem->add_child(block);
+      if (core.empty()) break;
+      active.erase(find(active.begin(), active.end(), core.back()));
+      result = solver.check(active, dummy);
+    }
+  }
+
+  delete problem;
+  return LINEAR_UNKNOWN;
+}
+
+PFormula Smt :: abstract_arithmetic(PFormula f, LinearSolver &solver,
+                                    map<string,int> &lookup,
+                                    vector<int> &atomvars) {
+  if (f->query_conjunction() || f->query_disjunction()) {
+    AndOr *formula = dynamic_cast<AndOr*>(f);
+    for (int i = 0; i < formula->query_number_children(); i++) {
+      PFormula child = formula->query_child(i);
+      PFormula newchild = abstract_arithmetic(child, solver, lookup,
+                                              atomvars);
+      if (newchild == NULL) return NULL;
+      if (newchild != child) delete formula->replace_child(i, newchild);
+    }
+    return formula;
+  }
+
+  else if (f->query_special("integer arithmetic")) {
+    IntegerArithmeticConstraint *p =
+      dynamic_cast<IntegerArithmeticConstraint*>(f);
+    string key = p->to_string();
+    if (lookup.find(key) == lookup.end()) {
+      if (solver.add_constraint(p->query_left(), p->query_right()) == -1)
+        return NULL;
+      lookup[key] = atomvars.size();
+      vars.add_vars(1);
+      atomvars.push_back(vars.query_size()-1);
+    }
+    return new Var(atomvars[lookup[key]]);
+  }
+
+  return f;
+}
+
 /* ========== updating and simplifying the formula ========== */
 
 void Smt :: global_replace(PFormula f, map<int,PPol> &substitution) {
@@ -317,6 +444,197 @@ bool Smt :: obvious_propagate(And *formula) {
   return changedstuff;
 }
 
+/* ========== bounds propagation ========== */
+
+bool Smt :: bounds_form(PPol p, long long sign, BoundsConstraint &c) {
+  if (p->query_integer()) {
+    c.constant += sign * dynamic_cast<Integer*>(p)->query_value();
+    return true;
+  }
+
+  if (p->query_unknown()) {
+    BoundsTerm term;
+    term.coef = sign;
+    term.unknowns.push_back(dynamic_cast<Unknown*>(p)->query_index());
+    c.terms.push_back(term);
+    return true;
+  }
+
+  if (p->query_sum()) {
+    for (int i = 0; i < p->number_children(); i++) {
+      if (!bounds_form(p->get_child(i), sign, c)) return false;
+    }
+    return true;
+  }
+
+  if (p->query_product()) {
+    BoundsTerm term;
+    term.coef = sign;
+    for (int i = 0; i < p->number_children(); i++) {
+      PPol child = p->get_child(i);
+      if (child->query_integer())
+        term.coef *= dynamic_cast<Integer*>(child)->query_value();
+      else if (child->query_unknown())
+        term.unknowns.push_back(dynamic_cast<Unknown*>(child)->query_index());
+      else return false;
+    }
+    if (term.unknowns.empty()) c.constant += term.coef;
+    else c.terms.push_back(term);
+    return true;
+  }
+
+  return false;
+}
+
+long long Smt :: bounds_product(vector<int> &unknowns, int skip, bool upper) {
+  long long ret = 1;
+  for (int i = 0; i < unknowns.size(); i++) {
+    if (i == skip) continue;
+    ret *= (upper ? maxima[unknowns[i]] : minima[unknowns[i]]);
+    if (ret > BOUNDS_LIMIT) return BOUNDS_LIMIT;
+  }
+  return ret;
+}
+
+bool Smt :: bounds_range(BoundsConstraint &c, long long &low,
+                         long long &high) {
+  low = high = c.constant;
+  for (int i = 0; i < c.terms.size(); i++) {
+    BoundsTerm &term = c.terms[i];
+    long long plow = bounds_product(term.unknowns, -1, false);
+    long long phigh = bounds_product(term.unknowns, -1, true);
+    if (phigh >= BOUNDS_LIMIT) return false;
+    if (term.coef > 0) { low += term.coef * plow; high += term.coef * phigh; }
+    else { low += term.coef * phigh; high += term.coef * plow; }
+  }
+  return true;
+}
+
+bool Smt :: tighten_bounds(BoundsConstraint &c, vector<int> &changed) {
+  long long low, best;
+  if (!bounds_range(c, low, best)) return true;
+  if (best < 0) return false;
+
+  // every term must be large (or small) enough that the other terms
+  // can make up the difference
+  for (int i = 0; i < c.terms.size(); i++) {
+    BoundsTerm &term = c.terms[i];
+    long long plow = bounds_product(term.unknowns, -1, false);
+    long long phigh = bounds_product(term.unknowns, -1, true);
+    if (term.coef > 0) {
+      // term.coef * P >= term.coef * phigh - best
+      long long need = term.coef * phigh - best;
+      if (need <= 0) continue;
+      need = (need + term.coef - 1) / term.coef;
+      if (need <= plow) continue;
+      for (int j = 0; j < term.unknowns.size(); j++) {
+        int x = term.unknowns[j];
+        long long others = bounds_product(term.unknowns, j, true);
+        if (others == 0) return false;
+        long long newmin = (need + others - 1) / others;
+        if (newmin > maxima[x]) return false;
+        if (newmin > minima[x]) {
+          minima[x] = newmin;
+          changed.push_back(x);
+        }
+      }
+    }
+    else {
+      // -term.coef * P <= best - term.coef * plow
+      long long allowed = plow + best / (-term.coef);
+      if (allowed >= phigh) continue;
+      for (int j = 0; j < term.unknowns.size(); j++) {
+        int x = term.unknowns[j];
+        long long others = bounds_product(term.unknowns, j, false);
+        if (others == 0) continue;
+        long long newmax = allowed / others;
+        if (newmax < minima[x]) return false;
+        if (newmax < maxima[x]) {
+          maxima[x] = newmax;
+          changed.push_back(x);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+int Smt :: propagate_bounds(And *formula) {
+  vector<BoundsConstraint> constraints;
+  vector< vector<int> > occurrences(minima.size());
+  int i, j;
+
+  for (i = 0; i < formula->query_number_children(); i++) {
+    PFormula child = formula->query_child(i);
+    if (!child->query_special("integer arithmetic")) continue;
+    IntegerArithmeticConstraint *p =
+      dynamic_cast<IntegerArithmeticConstraint*>(child);
+    BoundsConstraint c;
+    c.constant = 0;
+    if (!bounds_form(p->query_left(), 1, c) ||
+        !bounds_form(p->query_right(), -1, c)) continue;
+    for (j = 0; j < c.terms.size(); j++) {
+      vector<int> &xs = c.terms[j].unknowns;
+      for (int k = 0; k < xs.size(); k++)
+        occurrences[xs[k]].push_back(constraints.size());
+    }
+    constraints.push_back(c);
+  }
+
+  // worklist algorithm: when the bounds of an unknown change, all
+  // constraints it occurs in are checked again
+  vector<int> worklist;
+  vector<bool> queued(constraints.size(), true);
+  for (i = constraints.size()-1; i >= 0; i--) worklist.push_back(i);
+  bool anything = false;
+
+  while (!worklist.empty()) {
+    int current = worklist.back();
+    worklist.pop_back();
+    queued[current] = false;
+    vector<int> changed;
+    if (!tighten_bounds(constraints[current], changed)) return -1;
+    for (i = 0; i < changed.size(); i++) {
+      anything = true;
+      vector<int> &occ = occurrences[changed[i]];
+      for (j = 0; j < occ.size(); j++) {
+        if (queued[occ[j]]) continue;
+        queued[occ[j]] = true;
+        worklist.push_back(occ[j]);
+      }
+    }
+  }
+
+  return anything ? 1 : 0;
+}
+
+PFormula Smt :: decide_by_bounds(PFormula f) {
+  if (f->query_conjunction() || f->query_disjunction()) {
+    AndOr *formula = dynamic_cast<AndOr*>(f);
+    for (int i = 0; i < formula->query_number_children(); i++) {
+      PFormula child = formula->query_child(i);
+      PFormula newchild = decide_by_bounds(child);
+      if (newchild != child) formula->replace_child(i, newchild);
+    }
+    return formula;
+  }
+
+  if (f->query_special("integer arithmetic")) {
+    IntegerArithmeticConstraint *p =
+      dynamic_cast<IntegerArithmeticConstraint*>(f);
+    BoundsConstraint c;
+    c.constant = 0;
+    long long low, high;
+    if (!bounds_form(p->query_left(), 1, c) ||
+        !bounds_form(p->query_right(), -1, c) ||
+        !bounds_range(c, low, high)) return f;
+    if (low >= 0) { delete f; return new Top(); }
+    if (high < 0) { delete f; return new Bottom(); }
+  }
+
+  return f;
+}
+
 /* ========== less obvious decisions ========== */
 
 bool Smt :: check_single_sides(PFormula formula) {
@@ -578,26 +896,145 @@ void Smt :: save_sums(PFormula formula) {
   map<int,IntMap> used_known, used_unknown;
   vector<IntegerArithmeticConstraint*> v;
   get_arithmetic(formula, v);
+
+  // find sub-sums which occur in several places, so they are only
+  // encoded once
+  vector< vector<int> > sums;
   for (int i = 0; i < v.size(); i++) {
-    PPol left = handle_sums(v[i]->query_left(), used_known, used_unknown);
-    PPol right = handle_sums(v[i]->query_right(), used_known, used_unknown);
+    collect_sums(v[i]->query_left(), sums);
+    collect_sums(v[i]->query_right(), sums);
+  }
+  vector<SharedSum> shared;
+  share_sums(sums, shared, used_unknown);
+
+  for (int i = 0; i < v.size(); i++) {
+    PPol left = handle_sums(v[i]->query_left(), shared, used_known,
+                            used_unknown);
+    PPol right = handle_sums(v[i]->query_right(), shared, used_known,
+                             used_unknown);
     v[i]->replace_left(left);
     v[i]->replace_right(right);
   }
 }
 
-PPol Smt :: handle_sums(PPol p, map<int,IntMap> &used_known,
+void Smt :: collect_sums(PPol p, vector< vector<int> > &sums) {
+  for (int i = 0; i < p->number_children(); i++)
+    collect_sums(p->get_child(i), sums);
+  if (!p->query_sum()) return;
+
+  vector<int> ids;
+  for (int i = 0; i < p->number_children(); i++) {
+    if (p->get_child(i)->query_unknown())
+      ids.push_back(dynamic_cast<Unknown*>(p->get_child(i))->query_index());
+  }
+  if (ids.size() < 2) return;
+  sort(ids.begin(), ids.end());
+  sums.push_back(ids);
+}
+
+/* adds delta to the number of sums the given pair occurs in, keeping
+ * the pairs ordered by that number in order */
+static void count_pair(map<IntPair,int> &count,
+                       set< pair<int,IntPair> > &order,
+                       IntPair p, int delta) {
+  int &c = count[p];
+  if (c > 0) order.erase(make_pair(-c, p));
+  c += delta;
+  if (c > 0) order.insert(make_pair(-c, p));
+}
+
+/* adds delta to the counts of all pairs formed by sum[pos] and another
+ * element of sum */
+static void count_element(map<IntPair,int> &count,
+                          set< pair<int,IntPair> > &order,
+                          vector<int> &sum, int pos, int delta) {
+  for (int j = 0; j < sum.size(); j++) {
+    if (j == pos) continue;
+    IntPair p = sum[j] < sum[pos] ? IntPair(sum[j], sum[pos])
+                                  : IntPair(sum[pos], sum[j]);
+    count_pair(count, order, p, delta);
+  }
+}
+
+void Smt :: share_sums(vector< vector<int> > &sums,
+                       vector<SharedSum> &shared,
+                       map<int,IntMap> &used_unknown) {
+  map<IntPair,int> count;
+  set< pair<int,IntPair> > order;
+  map<int, set<int> > occurrences;
+  int i;
+
+  for (i = 0; i < sums.size(); i++) {
+    for (int j = 0; j < sums[i].size(); j++) {
+      for (int k = j+1; k < sums[i].size(); k++)
+        count_pair(count, order, IntPair(sums[i][j], sums[i][k]), 1);
+      occurrences[sums[i][j]].insert(i);
+    }
+  }
+
+  // repeatedly take the pair of unknowns which occurs together most
+  // often, introduce an unknown for it, and use it in all those sums
+  while (!order.empty() && -order.begin()->first > 1) {
+    IntPair best = order.begin()->second;
+    int id1 = best.first, id2 = best.second;
+    guarantee_existence(used_unknown, id1, id2, minima[id1] + minima[id2],
+                        maxima[id1] + maxima[id2]);
+    int id = used_unknown[id1][id2];
+    unknown_sums[id] = best;
+    SharedSum share;
+    share.parts = best;
+    share.result = id;
+    shared.push_back(share);
+
+    set<int> candidates = occurrences[id1];
+    for (set<int>::iterator it = candidates.begin();
+         it != candidates.end(); it++) {
+      vector<int> &sum = sums[*it];
+      vector<int>::iterator pos1 = find(sum.begin(), sum.end(), id1);
+      vector<int>::iterator pos2 = find(pos1 + 1, sum.end(), id2);
+      if (pos2 == sum.end()) continue;
+      // only the pairs with id1, id2 or id change
+      count_element(count, order, sum, pos2 - sum.begin(), -1);
+      sum.erase(pos2);
+      pos1 = find(sum.begin(), sum.end(), id1);
+      count_element(count, order, sum, pos1 - sum.begin(), -1);
+      *pos1 = id;
+      count_element(count, order, sum, pos1 - sum.begin(), 1);
+      sort(sum.begin(), sum.end());
+      if (find(sum.begin(), sum.end(), id1) == sum.end())
+        occurrences[id1].erase(*it);
+      if (find(sum.begin(), sum.end(), id2) == sum.end())
+        occurrences[id2].erase(*it);
+      occurrences[id].insert(*it);
+    }
+  }
+}
+
+bool Smt :: replace_pair(vector<int> &ids, IntPair pair, int id) {
+  int first = -1, second = -1;
+  for (int i = 0; i < ids.size(); i++) {
+    if (first == -1 && ids[i] == pair.first) first = i;
+    else if (second == -1 && ids[i] == pair.second) second = i;
+  }
+  if (first == -1 || second == -1) return false;
+  ids[first] = id;
+  ids.erase(ids.begin() + second);
+  return true;
+}
+
+PPol Smt :: handle_sums(PPol p, vector<SharedSum> &shared,
+                        map<int,IntMap> &used_known,
                         map<int,IntMap> &used_unknown) {
   int i;
 
   for (i = 0; i < p->number_children(); i++)
-    p->replace_child(i, handle_sums(p->get_child(i), used_known,
+    p->replace_child(i, handle_sums(p->get_child(i), shared, used_known,
                                     used_unknown));
 
   if (!p->query_sum()) return p;
 
   int base = 0;
-  int current = -1;
+  vector<int> ids;
 
   for (i = 0; i < p->number_children(); i++) {
     PPol child = p->get_child(i);
@@ -611,7 +1048,16 @@ PPol Smt :: handle_sums(PPol p, map<int,IntMap> &used_known,
       cout << "p = " << p->to_string() << endl;
       return p;
     }
-    int id = dynamic_cast<Unknown*>(child)->query_index();
+    ids.push_back(dynamic_cast<Unknown*>(child)->query_index());
+  }
+
+  // use the shared sub-sums, in the order they were introduced
+  for (i = 0; i < shared.size() && ids.size() > 1; i++)
+    replace_pair(ids, shared[i].parts, shared[i].result);
+
+  int current = -1;
+  for (i = 0; i < ids.size(); i++) {
+    int id = ids[i];
     if (current == -1) { current = id; continue; }
     int id1, id2;
     if (id < current) { id1 = id; id2 = current; }
@@ -23,6 +23,7 @@
  */
 
 #include "formula.h"
+#include "linearsolver.h"
 #include "polconstraintlist.h"
 #include "polynomial.h"
 #include <utility>
@@ -30,16 +31,52 @@
 typedef pair<int,int> IntPair;
 typedef map<int,int> IntMap;
 
+#define BOUNDS_LIMIT 1000000000
+  // products whose upper bound exceeds this are not used for bounds
+  // propagation
+
+struct SharedSum {
+  IntPair parts;
+  int result;
+    // the unknown result represents the sum of the unknowns in parts
+};
+
+struct BoundsTerm {
+  long long coef;
+  vector<int> unknowns;
+    // the term is coef * a_i1 * ... * a_ik; unknowns may repeat
+};
+
+struct BoundsConstraint {
+  vector<BoundsTerm> terms;
+  long long constant;
+    // the constraint is terms + constant >= 0
+};
+
 class Smt {
   private:
     vector<int> minima;
     vector<int> maxima;
+    vector<int> hints;
     map<int,int> squares;
     map<int,IntPair> known_products;
     map<int,IntPair> unknown_products;
     map<int,IntPair> known_sums;
     map<int,IntPair> unknown_sums;
 
+    LinearResult solve_linear(PFormula formula, vector<int> &values);
+      // if all integer arithmetic constraints in formula are linear,
+      // solves it without bit-blasting: the sat-solver picks which
+      // constraints should hold, the LinearSolver checks whether
+      // they can, and unsatisfiable combinations are excluded in the
+      // next round; formula itself is left unchanged
+    PFormula abstract_arithmetic(PFormula formula, LinearSolver &solver,
+                                 map<string,int> &lookup,
+                                 vector<int> &atomvars);
+      // replaces all integer arithmetic constraints in formula by a
+      // fresh variable (the same one for equal constraints), which
+      // is stored in atomvars at the index of the constraint in the
+      // solver; returns NULL if some constraint is not linear
     bool unit_propagate(And *formula);
       // if formula has an immediate child X or -X (with X a variable),
       // forces this to be true; other children are simplified
@@ -53,6 +90,29 @@ class Smt {
       // if certain parameters occur only on one side of the
       // inequalities, we can force them to their minimum or
       // maximum
+    int propagate_bounds(And *formula);
+      // tightens minima and maxima by interval propagation over the
+      // integer arithmetic constraints directly below formula, until
+      // a fixpoint is reached; returns -1 if the constraints cannot
+      // be satisfied, 1 if some bound changed and 0 otherwise
+    bool bounds_form(PPol p, long long sign, BoundsConstraint &c);
+      // adds sign * p to c; returns false if p is not a sum of
+      // products of integers and unknowns
+    long long bounds_product(vector<int> &unknowns, int skip, bool upper);
+      // returns the product of the upper (or lower) bounds of the
+      // given unknowns, leaving out the one at position skip
+    bool bounds_range(BoundsConstraint &c, long long &low,
+                      long long &high);
+      // sets low and high to the smallest and largest value the left-
+      // hand side of c can take; returns false if this is too large
+    bool tighten_bounds(BoundsConstraint &c, vector<int> &changed);
+      // tightens the bounds of unknowns in c so c can still be
+      // satisfied, and adds them to changed; returns false if c cannot
+      // be satisfied at all
+    PFormula decide_by_bounds(PFormula formula);
+      // replaces integer arithmetic constraints in formula which are
+      // always true or always false given minima and maxima by Top or
+      // Bottom
     void global_replace(PFormula f, map<int,PPol> &substitution);
       // does the given "unknown substitution" everywhere in the
       // formula
@@ -98,8 +158,21 @@ class Smt {
       // integer and an unknown by a single unknown
     void save_sums(PFormula formula);
       // alters the given formula, replacing sums a1 + ... + an by a
-      // single unknown representing the sum
-    PPol handle_sums(PPol p, map<int,IntMap> &used_known,
+      // single unknown representing the sum; pairs of unknowns which
+      // occur together in several sums are replaced by a shared
+      // unknown first
+    void collect_sums(PPol p, vector< vector<int> > &sums);
+      // adds the (sorted) unknowns of every sum in p to sums
+    void share_sums(vector< vector<int> > &sums, vector<SharedSum> &shared,
+                    map<int,IntMap> &used_unknown);
+      // repeatedly picks the pair of unknowns occurring together in
+      // the most sums and introduces an unknown for their sum, until
+      // no pair occurs in more than one sum; the introduced unknowns
+      // are stored in shared, in order
+    bool replace_pair(vector<int> &ids, IntPair pair, int id);
+      // if both parts of pair occur in ids, replaces them by id
+    PPol handle_sums(PPol p, vector<SharedSum> &shared,
+                     map<int,IntMap> &used_known,
                      map<int,IntMap> &used_unknown);
       // helping function for save_sums
     void guarantee_existence(map<int,IntMap> &used, int id1, int id2,
@@ -122,6 +195,10 @@ class Smt {
       // high, but the prover generally won't attempt more than the
       // lowest few values
 
+    void set_hints(vector<int> &hints);
+      // gives for each unknown a value to try first (or -1 for no
+      // preference); this is only used when no bit-blasting is needed
+
     bool solve(PFormula formula, vector<int> &values);
       // attempts to find solutions (both in Formula-variables and
       // in Polynomial-unknowns) so formula is satisfied
@@ -0,0 +1,250 @@
+/**************************************************************************
+   Copyright 2019 Cynthia Kop
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#include "strategy.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+Strategy :: Strategy(StrategyKind _kind, string _name, int _seconds)
+  :kind(_kind), name(_name), seconds(_seconds) {}
+
+Strategy :: ~Strategy() {
+  for (int i = 0; i < parts.size(); i++) delete parts[i];
+}
+
+/* ========================== parsing ============================ */
+
+/* splits text into names, numbers and single-character symbols */
+static bool tokenise(string text, vector<string> &tokens,
+                     string &error) {
+  for (int i = 0; i < text.length(); ) {
+    char c = text[i];
+    if (isspace(c)) { i++; continue; }
+    if (isalnum(c)) {
+      int j = i;
+      while (j < text.length() && isalnum(text[j])) j++;
+      tokens.push_back(text.substr(i, j - i));
+      i = j;
+      continue;
+    }
+    if (string(";|*[](),").find(c) == string::npos) {
+      error = "unexpected character '" + string(1, c) + "'";
+      return false;
+    }
+    tokens.push_back(string(1, c));
+    i++;
+  }
+  return true;
+}
+
+static string current(vector<string> &tokens, int pos) {
+  if (pos >= tokens.size()) return "end of strategy";
+  return "'" + tokens[pos] + "'";
+}
+
+Strategy *Strategy :: parse(string text, StrategyContext context,
+                            string &error) {
+  vector<string> tokens;
+  if (!tokenise(text, tokens, error)) return NULL;
+  int pos = 0;
+  Strategy *ret = parse_sequence(tokens, pos, error);
+  if (ret == NULL) return NULL;
+  if (pos < tokens.size()) {
+    error = "unexpected " + current(tokens, pos);
+    delete ret;
+    return NULL;
+  }
+  error = ret->check(context);
+  if (error != "") { delete ret; return NULL; }
+  return ret;
+}
+
+Strategy *Strategy :: parse_sequence(vector<string> &tokens, int &pos,
+                                     string &error) {
+  Strategy *first = parse_choice(tokens, pos, error);
+  if (first == NULL || pos >= tokens.size() || tokens[pos] != ";")
+    return first;
+  Strategy *ret = new Strategy(STRATEGY_SEQUENCE);
+  ret->parts.push_back(first);
+  while (pos < tokens.size() && tokens[pos] == ";") {
+    pos++;
+    Strategy *next = parse_choice(tokens, pos, error);
+    if (next == NULL) { delete ret; return NULL; }
+    ret->parts.push_back(next);
+  }
+  return ret;
+}
+
+Strategy *Strategy :: parse_choice(vector<string> &tokens, int &pos,
+                                   string &error) {
+  Strategy *first = parse_unit(tokens, pos, error);
+  if (first == NULL || pos >= tokens.size() || tokens[pos] != "|")
+    return first;
+  Strategy *ret = new Strategy(STRATEGY_CHOICE);
+  ret->parts.push_back(first);
+  while (pos < tokens.size() && tokens[pos] == "|") {
+    pos++;
+    Strategy *next = parse_unit(tokens, pos, error);
+    if (next == NULL) { delete ret; return NULL; }
+    ret->parts.push_back(next);
+  }
+  return ret;
+}
+
+Strategy *Strategy :: parse_unit(vector<string> &tokens, int &pos,
+                                 string &error) {
+  Strategy *ret = parse_atom(tokens, pos, error);
+  while (ret != NULL && pos < tokens.size()) {
+    Strategy *wrapper;
+    if (tokens[pos] == "*") {
+      wrapper = new Strategy(STRATEGY_REPEAT);
+      pos++;
+    }
+    else if (tokens[pos] == "[") {
+      if (pos + 2 >= tokens.size() || !isdigit(tokens[pos+1][0]) ||
+          tokens[pos+2] != "]") {
+        error = "a time budget should have the form [<seconds>]";
+        delete ret;
+        return NULL;
+      }
+      wrapper = new Strategy(STRATEGY_BUDGET, "",
+                             atoi(tokens[pos+1].c_str()));
+      pos += 3;
+    }
+    else break;
+    wrapper->parts.push_back(ret);
+    ret = wrapper;
+  }
+  return ret;
+}
+
+Strategy *Strategy :: parse_atom(vector<string> &tokens, int &pos,
+                                 string &error) {
+  if (pos >= tokens.size() || (tokens[pos] != "(" &&
+                               !isalpha(tokens[pos][0]))) {
+    error = "expected a step, but found " + current(tokens, pos);
+    return NULL;
+  }
+
+  // bracketed strategy
+  if (tokens[pos] == "(") {
+    pos++;
+    Strategy *ret = parse_sequence(tokens, pos, error);
+    if (ret == NULL) return NULL;
+    if (pos >= tokens.size() || tokens[pos] != ")") {
+      error = "expected ')', but found " + current(tokens, pos);
+      delete ret;
+      return NULL;
+    }
+    pos++;
+    return ret;
+  }
+
+  // step or race, possibly with arguments
+  string name = tokens[pos++];
+  Strategy *ret;
+  if (name == "race") ret = new Strategy(STRATEGY_RACE);
+  else ret = new Strategy(STRATEGY_STEP, name);
+  if (pos >= tokens.size() || tokens[pos] != "(") return ret;
+  do {
+    pos++;
+    Strategy *arg = parse_sequence(tokens, pos, error);
+    if (arg == NULL) { delete ret; return NULL; }
+    ret->parts.push_back(arg);
+  } while (pos < tokens.size() && tokens[pos] == ",");
+  if (pos >= tokens.size() || tokens[pos] != ")") {
+    error = "expected ')', but found " + current(tokens, pos);
+    delete ret;
+    return NULL;
+  }
+  pos++;
+  return ret;
+}
+
+/* ========================= validation ========================== */
+
+string Strategy :: check(StrategyContext context) {
+  string where;
+  if (context == TERMINATION_STRATEGY) where = "termination strategy";
+  if (context == DP_STRATEGY) where = "dependency pair strategy";
+  if (context == REDPAIR_STRATEGY) where = "reduction pair strategy";
+
+  if (kind == STRATEGY_STEP) {
+    bool known = false, arguments = false;
+    if (context == TERMINATION_STRATEGY)
+      known = name == "remove" || name == "fullremove" || name == "dp";
+    if (context == DP_STRATEGY) {
+      known = name == "graph" || name == "empty" || name == "subcrit" ||
+              name == "static" || name == "formative" ||
+              name == "redpair";
+      arguments = name == "redpair";
+    }
+    if (context == REDPAIR_STRATEGY)
+      known = name == "poly" || name == "horpo" || name == "pprod";
+    if (!known) return "unknown step '" + name + "' in " + where;
+    if (parts.size() > (arguments ? 1 : 0))
+      return "too many arguments for '" + name + "'";
+    if (parts.size() == 1) return parts[0]->check(REDPAIR_STRATEGY);
+    return "";
+  }
+
+  if (kind == STRATEGY_SEQUENCE && context == REDPAIR_STRATEGY)
+    return "sequences (;) cannot be used in a " + where;
+  if (kind == STRATEGY_REPEAT && context == REDPAIR_STRATEGY)
+    return "repetition (*) cannot be used in a " + where;
+  if (kind == STRATEGY_RACE && parts.size() < 2)
+    return "a race should have at least two arguments";
+
+  for (int i = 0; i < parts.size(); i++) {
+    string error = parts[i]->check(context);
+    if (error != "") return error;
+  }
+  return "";
+}
+
+bool Strategy :: is_step(string step) {
+  return kind == STRATEGY_STEP && name == step;
+}
+
+string Strategy :: to_string() {
+  string ret;
+  int i;
+  switch (kind) {
+    case STRATEGY_STEP:
+    case STRATEGY_RACE:
+      ret = kind == STRATEGY_RACE ? "race" : name;
+      for (i = 0; i < parts.size(); i++)
+        ret += (i == 0 ? "(" : ", ") + parts[i]->to_string();
+      if (parts.size() > 0) ret += ")";
+      return ret;
+    case STRATEGY_SEQUENCE:
+    case STRATEGY_CHOICE:
+      for (i = 0; i < parts.size(); i++) {
+        if (i > 0) ret += kind == STRATEGY_SEQUENCE ? " ; " : " | ";
+        ret += "(" + parts[i]->to_string() + ")";
+      }
+      return ret;
+    case STRATEGY_REPEAT:
+      return "(" + parts[0]->to_string() + ")*";
+    case STRATEGY_BUDGET: {
+      char budget[20];
+      sprintf(budget, "[%d]", seconds);
+      return "(" + parts[0]->to_string() + ")" + budget;
+    }
+  }
+  return ret;
+}
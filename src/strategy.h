@@ -0,0 +1,119 @@
+/**************************************************************************
+   Copyright 2019 Cynthia Kop
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ *************************************************************************/
+
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#define DEFAULT_TERMINATION_STRATEGY "remove ; dp ; fullremove"
+  // product polynomials are left for the end, as they are expensive,
+  // but in rare cases catch systems which dependency pairs do not
+#define DEFAULT_DP_STRATEGY \
+  "graph | empty | subcrit | static | formative | redpair"
+#define RACING_DP_STRATEGY \
+  "graph | empty | subcrit | static | formative | " \
+  "redpair(race(poly, horpo, pprod))"
+#define DEFAULT_REDPAIR_STRATEGY "poly | horpo | pprod"
+
+/**
+ * Strategies describe in which order the termination techniques are
+ * tried.  They are given by the following grammar:
+ *
+ *   sequence ::= choice ( ";" choice )*
+ *   choice   ::= unit ( "|" unit )*
+ *   unit     ::= atom ( "[" seconds "]" | "*" )*
+ *   atom     ::= name | name "(" sequence ( "," sequence )* ")" |
+ *                "(" sequence ")"
+ *
+ * Every step either makes progress or fails.  A sequence a ; b does
+ * a and then b, and makes progress if either did; a choice a | b
+ * only does b if a fails; s* repeats s for as long as it makes
+ * progress; s[n] gives s at most n seconds; and race(a, b, ...) does
+ * all of a, b, ... at the same time, and uses the first to succeed.
+ *
+ * Budgets and races are done in forked processes, and the result of
+ * the first process to make progress is used.  For termination
+ * strategies, this includes partial progress: if that process only
+ * removed some rules, it reports which rules remain, and the removal
+ * is repeated in the main process.  For dependency pair strategies,
+ * the result is spread over new problems and sets, so the process
+ * only reports success, and the strategy which succeeded is then
+ * done again in the main process.  A process which runs out of time
+ * is stopped, and whatever it did is lost.
+ *
+ * There are three kinds of strategies, which differ in the available
+ * steps and combinators:
+ * - termination strategies, with steps remove, fullremove and dp,
+ *   which may use everything
+ * - dependency pair strategies, with steps graph, empty, subcrit,
+ *   static, formative and redpair, which are applied to a single DP
+ *   problem (a sequence applies its next part to all the problems
+ *   which the previous parts left) and may use everything; redpair
+ *   optionally takes a reduction pair strategy as argument
+ * - reduction pair strategies, with steps poly, horpo and pprod,
+ *   which may use choices, budgets and races
+ */
+
+enum StrategyKind { STRATEGY_STEP, STRATEGY_SEQUENCE, STRATEGY_CHOICE,
+                    STRATEGY_REPEAT, STRATEGY_BUDGET, STRATEGY_RACE };
+
+enum StrategyContext { TERMINATION_STRATEGY, DP_STRATEGY,
+                       REDPAIR_STRATEGY };
+
+class Strategy {
+  private:
+    static Strategy *parse_sequence(vector<string> &tokens, int &pos,
+                                    string &error);
+    static Strategy *parse_choice(vector<string> &tokens, int &pos,
+                                  string &error);
+    static Strategy *parse_unit(vector<string> &tokens, int &pos,
+                                string &error);
+    static Strategy *parse_atom(vector<string> &tokens, int &pos,
+                                string &error);
+      // recursive descent parsing functions, following the grammar;
+      // these return NULL and set error if parsing fails
+
+  public:
+    StrategyKind kind;
+    string name;
+      // the name of the technique, for steps
+    int seconds;
+      // the time limit, for budgets
+    vector<Strategy*> parts;
+      // the components of a combinator, or the arguments of a step
+
+    Strategy(StrategyKind kind, string name = "", int seconds = 0);
+    ~Strategy();
+
+    static Strategy *parse(string text, StrategyContext context,
+                           string &error);
+      // parses the given text, and checks that it is a strategy of
+      // the given kind; returns NULL and sets error if not
+
+    string check(StrategyContext context);
+      // returns an explanation why this is not a valid strategy of
+      // the given kind, or the empty string if it is
+
+    string to_string();
+
+    bool is_step(string step);
+      // returns whether this strategy is the step with the given name
+};
+
+#endif
@@ -36,32 +36,41 @@ bool SubtermCriterionChecker :: run(DPSet &set, DPSet &strict,
     return false;
   }
 
-  formula = new And();
-  SatSolver sat;
-
+  // the plain subterm criterion can usually be decided without the
+  // SAT solver
   get_maximal_arities(set);
-  declare_nu_variables();
-  declare_strictness_variables(set.size());
-  map<string,int> sortordering;
-  add_main_requirements(set, false, sortordering, original_arities);
-  bool ret;
-  PFormula form = formula;
+  map<string,int> nu;
+  int found = find_projection(set, nu);
+  bool ret = found == 1;
 
-  if (sat.solve(form)) {
-    ret = true;
-    get_solution(set, strict, nonstrict, F, original_arities, false);
+  if (found == -1) {
+    formula = new And();
+    SatSolver sat;
+
+    declare_nu_variables();
+    declare_strictness_variables(set.size());
+    map<string,int> sortordering;
+    add_main_requirements(set, false, sortordering, original_arities);
+    PFormula form = formula;
+
+    ret = sat.solve(form);
+    if (ret) read_projection(nu);
+
+    vars.reset();
+    delete form;
+    formula = NULL;
+  }
+
+  if (ret) {
+    get_solution(set, strict, nonstrict, F, original_arities, false, nu);
     wout.succeed_method("subterm criterion");
   }
   else {
-    ret = false;
     wout.verbose_print("Unfortunately, there is no suitable "
       "projection function to apply the subterm criterion.\n");
     wout.abort_method("subterm criterion");
   }
   
-  vars.reset();
-  delete form;
-  formula = NULL;
   return ret;
 }
 
@@ -93,7 +102,9 @@ bool SubtermCriterionChecker :: run_static(DPSet &set, DPSet &strict,
 
   if (sat.solve(form)) {
     ret = true;
-    get_solution(set, strict, nonstrict, F, original_arities, true);
+    map<string,int> nu;
+    read_projection(nu);
+    get_solution(set, strict, nonstrict, F, original_arities, true, nu);
     wout.succeed_method("accessible subterm criterion");
   }
   else {
@@ -209,6 +220,107 @@ void SubtermCriterionChecker :: add_main_requirements(DPSet &set,
   }
 }
 
+int SubtermCriterionChecker :: find_projection(DPSet &set,
+                                               map<string,int> &nu) {
+  int i, j, k;
+
+  // compare all arguments of the left- and right-hand sides once
+  Checks checks(set.size());
+  vector<string> fs, gs;
+  for (i = 0; i < set.size(); i++) {
+    vector<PTerm> lsplit = set[i]->query_left()->split();
+    vector<PTerm> rsplit = set[i]->query_right()->split();
+    string f = lsplit[0]->to_string(false);
+    string g = rsplit[0]->to_string(false);
+    fs.push_back(f);
+    gs.push_back(g);
+    checks[i].resize(arities[f]);
+    for (j = 0; j < arities[f]; j++) {
+      for (k = 0; k < arities[g]; k++)
+        checks[i][j].push_back(check_subterm(lsplit[j+1], rsplit[k+1]));
+    }
+  }
+
+  map<string, vector<bool> > allowed;
+  for (ArList::iterator it = arities.begin(); it != arities.end(); it++)
+    allowed[it->first] = vector<bool>(it->second, true);
+  if (!propagate_projection(set, checks, allowed)) return 0;
+
+  // make each possible pair strict in turn; if the candidates still
+  // admit a projection, we pick the first remaining candidate for
+  // each symbol, which succeeds unless the candidates interfere
+  bool stuck = false;
+  for (i = 0; i < set.size(); i++) {
+    string f = fs[i], g = gs[i];
+    for (j = 0; j < arities[f]; j++) {
+      for (k = 0; k < arities[g]; k++) {
+        if (checks[i][j][k] != 1) continue;
+        if (!allowed[f][j] || !allowed[g][k]) continue;
+        if (f == g && j != k) continue;
+
+        map<string, vector<bool> > attempt = allowed;
+        attempt[f] = vector<bool>(arities[f], false);
+        attempt[f][j] = true;
+        attempt[g] = vector<bool>(arities[g], false);
+        attempt[g][k] = true;
+        if (!propagate_projection(set, checks, attempt)) continue;
+
+        bool ok = true;
+        map<string, vector<bool> >::iterator it;
+        for (it = attempt.begin(); it != attempt.end() && ok; it++) {
+          int n = 0;
+          while (!it->second[n]) n++;
+          it->second = vector<bool>(it->second.size(), false);
+          it->second[n] = true;
+          nu[it->first] = n+1;
+          ok = propagate_projection(set, checks, attempt);
+        }
+        if (ok) return 1;
+        stuck = true;
+      }
+    }
+  }
+
+  return stuck ? -1 : 0;
+}
+
+bool SubtermCriterionChecker :: propagate_projection(DPSet &set,
+                          Checks &checks,
+                          map<string, vector<bool> > &allowed) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 0; i < set.size(); i++) {
+      string f = set[i]->query_left()->query_head()->to_string(false);
+      string g = set[i]->query_right()->query_head()->to_string(false);
+      vector<bool> &fallowed = allowed[f], &gallowed = allowed[g];
+      vector<bool> fsupported(fallowed.size(), false);
+      vector<bool> gsupported(gallowed.size(), false);
+
+      // a candidate remains only if some candidate on the other side
+      // can be combined with it
+      for (int j = 0; j < fallowed.size(); j++) {
+        for (int k = 0; k < gallowed.size(); k++) {
+          if (fallowed[j] && gallowed[k] && checks[i][j][k] >= 0) {
+            fsupported[j] = true;
+            gsupported[k] = true;
+          }
+        }
+      }
+      if (fsupported != fallowed) { fallowed = fsupported; changed = true; }
+      if (gsupported != gallowed) { gallowed = gsupported; changed = true; }
+    }
+  }
+
+  map<string, vector<bool> >::iterator it;
+  for (it = allowed.begin(); it != allowed.end(); it++) {
+    bool any = false;
+    for (int j = 0; j < it->second.size(); j++) any |= it->second[j];
+    if (!any) return false;
+  }
+  return true;
+}
+
 int SubtermCriterionChecker :: check_subterm(PTerm a, PTerm b) {
   if (a->equals(b)) return 0;
   if (a->query_meta()) return -1;
@@ -299,26 +411,30 @@ bool SubtermCriterionChecker :: positions_okay(PType sigma, string kappa,
          positions_okay(b, kappa, sortord, positive);
 }
 
+void SubtermCriterionChecker :: read_projection(map<string,int> &nu) {
+  for (ArList::iterator it = varstart.begin(); it != varstart.end(); it++) {
+    string f = it->first;
+    int start = it->second;
+    int N = arities[f];
+    for (int i = 0; i < N; i++) {
+      if (vars.query_value(start+i) == TRUE) nu[f] = i+1;
+    }
+  }
+}
+
 void SubtermCriterionChecker :: get_solution(DPSet &set, DPSet &stricts,
                                              DPSet &nonstricts,
                                              Alphabet &F,
                                              ArList &original_arities,
-                                             bool accessible) {
+                                             bool accessible,
+                                             map<string,int> &nu) {
   wout.print("We apply the " + string(accessible ? "accessible " : "") +
     "subterm criterion with the following projection function:\n");
 
-  // get and print projection function
-  map<string,int> nu;
+  // print projection function
   wout.start_table();
-  for (ArList::iterator it = varstart.begin(); it != varstart.end(); it++) {
-    // get nu(f)
+  for (ArList::iterator it = arities.begin(); it != arities.end(); it++) {
     string f = it->first;
-    int start = it->second;
-    int N = arities[f];
-    for (int i = 0; i < N; i++) {
-      if (vars.query_value(start+i) == TRUE) nu[f] = i+1;
-    }
-    // print nu(f)
     vector<string> entry;
     entry.push_back(wout.projection_symbol() + "(" + f + ")");
     entry.push_back("=");
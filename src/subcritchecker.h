@@ -18,6 +18,9 @@
 #include "formula.h"
 
 typedef map<string,int> ArList;
+typedef vector< vector< vector<int> > > Checks;
+  // checks[i][j][k] compares argument j of the left-hand side of pair
+  // i with argument k of its right-hand side, as check_subterm does
 
 class SubtermCriterionChecker {
   private:
@@ -59,11 +62,27 @@ class SubtermCriterionChecker {
                         map<string,int> &sortord, bool positive);
       // returns whether Pos^x(kappa, sigma) = Pos(kappa, sigma),
       // where x is + if positive is true, otherwise -
+    int find_projection(DPSet &set, map<string,int> &nu);
+      // searches for a projection function directly: candidate
+      // positions which fail on some pair are dropped until a fixpoint
+      // is reached, and then positions are chosen one symbol at a
+      // time; returns 1 if a projection with at least one strict pair
+      // was found (and stores it in nu), 0 if none exists, and -1 if
+      // the search got stuck, so the SAT encoding should be used
+    bool propagate_projection(DPSet &set, Checks &checks,
+                              map<string, vector<bool> > &allowed);
+      // removes the candidate positions for which some pair cannot be
+      // oriented, until nothing changes; returns false if this leaves
+      // some symbol without any candidates
+    void read_projection(map<string,int> &nu);
+      // assuming all SAT-variables are instantiated, stores the
+      // projection function they describe in nu
     void get_solution(DPSet &set, DPSet &strict, DPSet &nonstrict,
-                      Alphabet &F, ArList &arities, bool accessible);
-      // assuming all SAT-variables are instantiated, print the
-      // solution in the output module, and put the strictly oriented
-      // dependency pairs in the removed set
+                      Alphabet &F, ArList &arities, bool accessible,
+                      map<string,int> &nu);
+      // print the solution for the given projection function in the
+      // output module, and put the strictly oriented dependency pairs
+      // in the removed set
 
   public:
     bool run(DPSet &dps, DPSet &strict, DPSet &nonstrict,
@@ -24,10 +24,13 @@
 #include "inputreaderfo.h"
 #include "nonterminator.h"
 #include "outputmodule.h"
+#include "parallel.h"
 #include "ruleremover.h"
 #include "xmlreader.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <cstdlib>
 #include <random>
 
@@ -79,6 +82,7 @@ void Wanda :: run(vector<string> args) {
     else determine_termination();
 
     // clear alphabet and rules for this run
+    solved_problems.clear();
     Sigma.clear();
     for (int j = 0; j < rules.size(); j++) delete rules[j];
     rules.clear();
@@ -102,6 +106,9 @@ void Wanda :: parse_runtime_arguments(vector<string> &args) {
   firstorder = "firstorderprover";
   firstordernont = "firstordernonprover";
   outputfile = "";
+  workers = 1;
+  race = false;
+  strategyfile = "";
   string disable = "";
   string style = "";
   use_betafirst = false;
@@ -124,6 +131,7 @@ void Wanda :: parse_runtime_arguments(vector<string> &args) {
     else if (arg == "--betafirst") use_betafirst = true;
     else if (arg == "--dontsimplify") simplify_meta = false;
     else if (arg == "--formal") { formal = true; simplify_meta = false; }
+    else if (arg == "--race") race = true;
     else if (arg.substr(0,9) == "--format=")
       formalism = arg.substr(9);
     else if (arg.substr(0,13) == "--firstorder=")
@@ -138,6 +146,16 @@ void Wanda :: parse_runtime_arguments(vector<string> &args) {
       style = arg.substr(8);
     else if (arg.substr(0,9) == "--output=")
       outputfile = arg.substr(9);
+    else if (arg.substr(0,11) == "--strategy=")
+      strategyfile = arg.substr(11);
+    else if (arg.substr(0,10) == "--workers=") {
+      workers = atoi(arg.substr(10).c_str());
+      if (workers < 1) {
+        error = "Could not parse runtime arguments: the number of "
+          "workers should be a positive integer.";
+        return;
+      }
+    }
     else if (arg.substr(0,2) == "--") {
       error = "Could not parse runtime arguments: unknown "
         "parameter, '" + arg + "'.";
@@ -189,6 +207,21 @@ void Wanda :: parse_runtime_arguments(vector<string> &args) {
     return;
   }
 
+  // determine the strategies
+  if (strategyfile != "") {
+    read_strategy(strategyfile);
+    if (error != "") return;
+  }
+  else {
+    termination_strategy = Strategy::parse(DEFAULT_TERMINATION_STRATEGY,
+                                           TERMINATION_STRATEGY, error);
+    dp_strategy = NULL;
+    if (race) {
+      dp_strategy = Strategy::parse(RACING_DP_STRATEGY, DP_STRATEGY,
+                                    error);
+    }
+  }
+
   // deal with disable
   allow_nontermination = (disable.find("nt") == string::npos);
   allow_rulesremoval   = (disable.find("rem") == string::npos);
@@ -498,72 +531,276 @@ void Wanda :: check_query() {
   }
 }
 
+void Wanda :: read_strategy(string filename) {
+  ifstream file(filename.c_str());
+  if (!file) {
+    error = "Could not read strategy file " + filename + ".";
+    return;
+  }
+
+  // split the file into its termination and dp sections
+  string termination = "", dp = "", *section = NULL, line;
+  while (getline(file, line)) {
+    int k = line.find('#');
+    if (k != string::npos) line = line.substr(0, k);
+    k = line.find_first_not_of(" \t");
+    if (k == string::npos) continue;
+    if (line.substr(k, 12) == "termination:") {
+      section = &termination;
+      line = line.substr(k + 12);
+    }
+    else if (line.substr(k, 3) == "dp:") {
+      section = &dp;
+      line = line.substr(k + 3);
+    }
+    else if (section == NULL) {
+      error = "Strategy file " + filename + " should start with "
+        "termination: or dp:.";
+      return;
+    }
+    *section += line + " ";
+  }
+
+  // and parse both
+  if (termination == "") termination = DEFAULT_TERMINATION_STRATEGY;
+  termination_strategy = Strategy::parse(termination,
+                                         TERMINATION_STRATEGY, error);
+  if (error != "") {
+    error = "Could not parse termination strategy: " + error + ".";
+    return;
+  }
+  dp_strategy = NULL;
+  if (dp != "") {
+    dp_strategy = Strategy::parse(dp, DP_STRATEGY, error);
+    if (error != "")
+      error = "Could not parse dependency pair strategy: " + error + ".";
+  }
+}
+
 string Wanda :: prove_termination(Alphabet &F, vector<MatchRule*> &R,
                                   int handle_nontermination) {
   wout.start_method("termination");
 
+  bool progress;
+  string answer = run_strategy(termination_strategy, F, R,
+                               handle_nontermination, progress);
+
+  if (answer == "YES") {
+    wout.succeed_method("termination");
+    return "YES";
+  }
+  wout.abort_method("termination");
+  if (answer == "NO") {
+    wout.import_progress(nontermination_proof);
+    return "NO";
+  }
+  return "MAYBE";
+}
+
+string Wanda :: run_strategy(Strategy *how, Alphabet &F,
+                             vector<MatchRule*> &R,
+                             int handle_nontermination,
+                             bool &progress) {
+  int i;
+  string answer;
+  bool subprogress;
+  progress = false;
+
+  switch (how->kind) {
+    case STRATEGY_SEQUENCE:
+      for (i = 0; i < how->parts.size(); i++) {
+        answer = run_strategy(how->parts[i], F, R,
+                              handle_nontermination, subprogress);
+        if (answer != "") return answer;
+        progress |= subprogress;
+      }
+      return "";
+
+    case STRATEGY_CHOICE:
+      for (i = 0; i < how->parts.size() && !progress; i++) {
+        answer = run_strategy(how->parts[i], F, R,
+                              handle_nontermination, progress);
+        if (answer != "") return answer;
+      }
+      return "";
+
+    case STRATEGY_REPEAT:
+      do {
+        answer = run_strategy(how->parts[0], F, R,
+                              handle_nontermination, subprogress);
+        if (answer != "") return answer;
+        progress |= subprogress;
+      } while (subprogress);
+      return "";
+
+    case STRATEGY_BUDGET:
+    case STRATEGY_RACE:
+      // as the output cannot be shown while working, verbose mode
+      // works sequentially
+      if (wout.query_verbose()) {
+        for (i = 0; i < how->parts.size() && !progress; i++) {
+          answer = run_strategy(how->parts[i], F, R,
+                                handle_nontermination, progress);
+          if (answer != "") return answer;
+        }
+        return "";
+      }
+      return run_workers(how->parts, F, R, handle_nontermination,
+                         how->kind == STRATEGY_BUDGET ?
+                           how->seconds * 1000 : -1, progress);
+
+    case STRATEGY_STEP:
+      break;
+  }
+
   // start off by removing rules as much as possible, but do not
   // use product polynomials if we're still going to do
   // dependency pairs, because those cause timeouts
-  if (allow_redpair) {
-    RuleRemover remover(allow_polynomials, allow_horpo,
-                         allow_polyprod && !allow_dp);
+  if (how->name == "remove" || how->name == "fullremove") {
+    if (!allow_redpair) return "";
+    // if dependency pairs are disabled, remove already uses products
+    if (how->name == "fullremove" && !allow_dp) return "";
+    int before = R.size();
+    RuleRemover remover(allow_polynomials, allow_horpo, allow_polyprod &&
+                        (how->name == "fullremove" || !allow_dp));
     if (allow_rulesremoval) remover.remove_rules(F, R);
     else remover.remove_all(F, R);
-    if (R.empty()) {
-      wout.succeed_method("termination");
-      return "YES";
-    }
+    progress = R.size() < before;
+    return R.empty() ? "YES" : "";
   }
 
-  // with the remaining rules, use the dependency pair framework
-  if (allow_dp) {
-    DependencyFramework framework(F, R, firstorder, firstordernont,
-                                  allow_static_dp, allow_dynamic_dp);
-    if (!allow_graph) framework.disable_graph();
-    if (!allow_subcrit) framework.disable_subcrit();
-    if (!allow_polynomials) framework.disable_polynomials();
-    if (!allow_polyprod) framework.disable_product_polynomials();
-    if (!allow_horpo) framework.disable_horpo();
-    if (!allow_local) framework.disable_abssimple();
-    if (!allow_formative) framework.disable_formative();
-    if (!allow_usable) framework.disable_usable();
-    if (!allow_fwrt) framework.disable_fwrt();
-    if (!allow_uwrt) framework.disable_uwrt();
-
-    if (handle_nontermination != 0 && framework.first_order_non_terminating()) {
-      wout.abort_method("termination");
-      framework.document_non_terminating();
-      return "NO";
-    }
+  if (how->name == "dp") {
+    answer = dependency_pairs(F, R, handle_nontermination);
+    progress = answer != "";
+    return answer;
+  }
 
-    else if (framework.terminating()) {
-      wout.succeed_method("termination");
-      return "YES";
-    }
+  return "";
+}
 
-    else if (handle_nontermination == 1 && framework.proved_non_terminating()) {
-      wout.abort_method("termination");
-      framework.document_non_terminating();
-      return "NO";
+string Wanda :: run_workers(vector<Strategy*> &options, Alphabet &F,
+                            vector<MatchRule*> &R,
+                            int handle_nontermination, int limit,
+                            bool &progress) {
+  int i, n = options.size();
+  progress = false;
+  WorkerPool pool(n);
+  for (i = 0; i < n; i++) {
+    if (!pool.start(i)) continue;
+    // worker: report the answer and the indexes of the rules which
+    // are left, followed by the proof text
+    vector<MatchRule*> original = R;
+    wout.mark_progress();
+    bool ok;
+    string answer = run_strategy(options[i], F, R,
+                                 handle_nontermination, ok);
+    string kept;
+    for (int j = 0; j < original.size(); j++) {
+      if (find(R.begin(), R.end(), original[j]) != R.end())
+        kept += wout.str(j) + " ";
     }
-  }
-
-  // in rare cases, rule removal may catch systems which dependency
-  // pairs do not; for these cases, try full rule removal, so
-  // including product polynomials, afterwards
-  if (allow_redpair && allow_dp) {
-    RuleRemover remover(allow_polynomials, allow_horpo, allow_polyprod);
-    if (allow_rulesremoval) remover.remove_rules(F, R);
-    else remover.remove_all(F, R);
-    if (R.empty()) {
-      wout.succeed_method("termination");
-      return "YES";
+    string proof;
+    if (answer == "NO") proof = nontermination_proof;
+    else proof = wout.export_progress();
+    WorkerPool::finish(answer != "" || ok,
+                       answer + "\n" + kept + "\n" + proof);
+  }
+
+  // options for which no worker could be forked are done here, as a
+  // choice would do them (without a time limit); their progress is
+  // already in place, so needs no replaying
+  long deadline = limit < 0 ? -1 : WorkerPool::milliseconds() + limit;
+  for (i = 0; i < n; i++) {
+    if (!pool.take_failure(i)) continue;
+    wout.mark_progress();
+    bool ok;
+    string answer = run_strategy(options[i], F, R,
+                                 handle_nontermination, ok);
+    if (answer == "" && !ok) { wout.take_progress(); continue; }
+    // as for workers, a non-termination answer only keeps its proof
+    if (answer == "NO") wout.take_progress();
+    else wout.export_progress();
+    pool.cancel();
+    progress = true;
+    return answer;
+  }
+
+  int task;
+  bool success;
+  string data;
+  while (true) {
+    int remaining = -1;
+    if (deadline >= 0) {
+      remaining = deadline - WorkerPool::milliseconds();
+      if (remaining < 0) remaining = 0;
     }
-  }
+    if (!pool.wait(task, success, data, remaining)) return "";
+    if (success) break;
+  }
+  pool.cancel();
+
+  progress = true;
+  int k = data.find('\n');
+  int m = data.find('\n', k + 1);
+  string answer = data.substr(0, k);
+  if (answer == "NO") {
+    nontermination_proof = data.substr(m + 1);
+    return answer;
+  }
+  wout.import_progress(data.substr(m + 1));
+
+  // if the worker determined termination, nothing remains to be done;
+  // otherwise, replay its rule removal
+  vector<bool> keep(R.size(), false);
+  if (answer == "") {
+    istringstream kept(data.substr(k + 1, m - k - 1));
+    int index;
+    while (kept >> index) keep[index] = true;
+  }
+  vector<MatchRule*> remaining;
+  for (i = 0; i < R.size(); i++) {
+    if (keep[i]) remaining.push_back(R[i]);
+    else delete R[i];
+  }
+  R = remaining;
+  return answer;
+}
 
-  wout.abort_method("termination");
-  return "MAYBE";
+string Wanda :: dependency_pairs(Alphabet &F, vector<MatchRule*> &R,
+                                 int handle_nontermination) {
+  if (!allow_dp) return "";
+
+  DependencyFramework framework(F, R, firstorder, firstordernont,
+                                allow_static_dp, allow_dynamic_dp);
+  if (!allow_graph) framework.disable_graph();
+  if (!allow_subcrit) framework.disable_subcrit();
+  if (!allow_polynomials) framework.disable_polynomials();
+  if (!allow_polyprod) framework.disable_product_polynomials();
+  if (!allow_horpo) framework.disable_horpo();
+  if (!allow_local) framework.disable_abssimple();
+  if (!allow_formative) framework.disable_formative();
+  if (!allow_usable) framework.disable_usable();
+  if (!allow_fwrt) framework.disable_fwrt();
+  if (!allow_uwrt) framework.disable_uwrt();
+  framework.set_workers(workers);
+  if (dp_strategy != NULL) framework.set_strategy(dp_strategy);
+  framework.set_solved_cache(&solved_problems);
+
+  bool nonterminating = false;
+  if (handle_nontermination != 0 &&
+      framework.first_order_non_terminating()) nonterminating = true;
+  else if (framework.terminating()) return "YES";
+  else if (handle_nontermination == 1 &&
+           framework.proved_non_terminating()) nonterminating = true;
+  if (!nonterminating) return "";
+
+  // the explanation is shown instead of the termination proof so far
+  wout.start_method("non-termination");
+  wout.mark_progress();
+  framework.document_non_terminating();
+  nontermination_proof = wout.export_progress();
+  wout.abort_method("non-termination");
+  return "NO";
 }
 
 void Wanda :: determine_termination() {
@@ -645,6 +882,7 @@ int main(int argc, char **argv) {
   vector<string> args;
   for (int i = 1; i < argc; i++) args.push_back(argv[i]);
 
+  WorkerPool::clean_up_on_termination();
   Wanda wanda;
   wanda.run(args);
   return 0;
@@ -24,7 +24,9 @@
  */
 
 #include "alphabet.h"
+#include "dpframework.h"
 #include "matchrule.h"
+#include "strategy.h"
 
 class Wanda {
   private:
@@ -73,6 +75,22 @@ class Wanda {
     string outputfile;
       // the file to which the proof should be written; if empty this
       // is just stdout
+    int workers;
+      // the number of processes which may be used at the same time
+    bool race;
+      // try the reduction pair strategies at the same time
+    string strategyfile;
+      // a file describing the order in which to try techniques
+    Strategy *termination_strategy;
+    Strategy *dp_strategy;
+      // the strategies to use (dp_strategy may be NULL, in which case
+      // the dependency pair framework uses its default)
+    string nontermination_proof;
+      // the explanation of the last non-termination result of the
+      // dependency pair framework, as exported by the output module
+    SolvedCache solved_problems;
+      // reduction pair proofs found by the dependency pair frameworks
+      // for the current system, shared between its variations
     bool allow_nontermination;
                               // 2: only in the first-order part
     bool allow_redpair;
@@ -129,12 +147,39 @@ class Wanda {
       // checks whether the given query is satisfies, and outputs
       // YES or NO accordingly
 
+    void read_strategy(string filename);
+      // reads the termination and dependency pair strategies from the
+      // given file, and sets error if this fails
+
     string prove_termination(Alphabet &F, vector<MatchRule*> &R,
                              int handle_nontermination);
       // main functionality for determine_termination, using a given
       // alphabet and set of rules, and which may handle nontermination
       // checks within the DP framework in three different ways
 
+    string run_strategy(Strategy *how, Alphabet &F,
+                        vector<MatchRule*> &R,
+                        int handle_nontermination, bool &progress);
+      // applies the given termination strategy; returns YES or NO if
+      // this determines termination, and the empty string otherwise,
+      // in which case progress indicates whether any rules were
+      // removed
+
+    string run_workers(vector<Strategy*> &options, Alphabet &F,
+                       vector<MatchRule*> &R,
+                       int handle_nontermination, int limit,
+                       bool &progress);
+      // applies the given strategies at the same time, each in its
+      // own worker process, and uses the result of the first which
+      // makes progress: its answer is returned, and if it only
+      // removed some rules, R is reduced to the rules it kept; if
+      // limit is non-negative, the workers are cancelled after limit
+      // milliseconds
+
+    string dependency_pairs(Alphabet &F, vector<MatchRule*> &R,
+                            int handle_nontermination);
+      // the dp step of a termination strategy
+
     void determine_termination();
       // tries to decide whether the current system is terminating,
       // and prints YES/NO/MAYBE, as well as an explanation if silent